@@ -13,7 +13,7 @@ for fakechroot_chroot_env_d in `echo $PATH | tr ':' ' '`; do
 $fakechroot_chroot_env_d/chroot=${fakechroot_bindir:-@sbindir@}/chroot.fakechroot
 $fakechroot_chroot_env_d/env=${fakechroot_bindir:-@bindir@}/env.fakechroot
 $fakechroot_chroot_env_d/ischroot=/bin/true
-$fakechroot_chroot_env_d/ldconfig=/bin/true
+$fakechroot_chroot_env_d/ldconfig=${fakechroot_bindir:-@sbindir@}/ldconfig.fakechroot
 $fakechroot_chroot_env_d/ldd=${fakechroot_bindir:-@bindir@}/ldd.fakechroot"
 done
 
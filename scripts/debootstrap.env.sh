@@ -12,7 +12,7 @@ fakechroot_debootstrap_env_cmd_subst="/bin/mount=/bin/true
 @DEVFS@=/bin/true
 @INSSERV@=/bin/true
 @ISCHROOT@=/bin/true
-@LDCONFIG@=/bin/true
+@LDCONFIG@=${fakechroot_bindir:-@sbindir@}/ldconfig.fakechroot
 @LDD@=${fakechroot_bindir:-@bindir@}/ldd.fakechroot
 @MKFIFO@=/bin/true
 @SYSTEMCTL@=/bin/true
@@ -21,6 +21,7 @@ fakechroot_usage () {
     fakechroot [-l|--lib fakechrootlib]
                [-d|--elfloader ldso]
                [-s|--use-system-libs]
+               [-S|--supervisor]
                [-e|--environment type]
                [-c|--config-dir directory]
                [-b|--bindir directory]
@@ -78,6 +79,7 @@ fakechroot_sysconfdir=@sysconfdir@
 fakechroot_confdir=
 fakechroot_environment=
 fakechroot_bindir=
+fakechroot_supervisor=
 
 if [ "$fakechroot_paths" = "no" ]; then
     fakechroot_paths=
@@ -96,11 +98,11 @@ fakechroot_getopttest=`getopt --version`
 case $fakechroot_getopttest in
     getopt*)
         # GNU getopt
-        fakechroot_opts=`getopt -q -l lib: -l elfloader: -l use-system-libs -l config-dir: -l environment: -l bindir: -l version -l help -- +l:d:sc:e:b:vh "$@"`
+        fakechroot_opts=`getopt -q -l lib: -l elfloader: -l use-system-libs -l supervisor -l config-dir: -l environment: -l bindir: -l version -l help -- +l:d:sSc:e:b:vh "$@"`
         ;;
     *)
         # POSIX getopt ?
-        fakechroot_opts=`getopt l:d:sc:e:b:vh "$@"`
+        fakechroot_opts=`getopt l:d:sSc:e:b:vh "$@"`
         ;;
 esac
 
@@ -134,6 +136,9 @@ while [ $# -gt 0 ]; do
         -s|--use-system-libs)
             fakechroot_paths="${fakechroot_paths:+$fakechroot_paths:}/usr/lib:/lib"
             ;;
+        -S|--supervisor)
+            fakechroot_supervisor=yes
+            ;;
         -c|--config-dir)
             fakechroot_confdir=$1
             shift
@@ -167,6 +172,16 @@ if [ -n "$FAKECHROOT_ELFLOADER" ]; then
 fi
 
 
+# Run statically linked binaries via seccomp supervisor
+if [ "$fakechroot_supervisor" = yes ]; then
+    FAKECHROOT_SUPERVISOR="${FAKECHROOT_SUPERVISOR:-@pkglibexecdir@/fakechroot-supervisor}"
+    if [ ! -x "$FAKECHROOT_SUPERVISOR" ]; then
+        fakechroot_die "fakechroot: supervisor $FAKECHROOT_SUPERVISOR not found, aborting."
+    fi
+    export FAKECHROOT_SUPERVISOR
+fi
+
+
 # Swap libfakechroot and libfakeroot in LD_PRELOAD if needed
 # libfakeroot must come first
 # an alternate fakeroot library may be given
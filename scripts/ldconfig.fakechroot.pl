@@ -0,0 +1,103 @@
+#!@PERL@
+
+# fakeldconfig
+#
+# Replacement for ldconfig which writes the index of libraries for
+# libfakechroot.  dlopen() uses it as a fallback when the library is not
+# found in the search path of the real dynamic linker.
+#
+# LGPL
+
+use strict;
+
+$ENV{LANG} = $ENV{LC_ALL} = 'C';
+
+my $Index = '/etc/ld.so.fakechroot';
+
+my @Ld_Library_Path = ();
+my @Default_Path = qw(/lib /usr/lib /lib64 /usr/lib64 /lib32 /usr/lib32 /libx32 /usr/libx32);
+
+my $Base = defined $ENV{FAKECHROOT_BASE_ORIG} ? $ENV{FAKECHROOT_BASE_ORIG} : '';
+
+
+sub load_ldsoconf {
+    my ($file) = @_;
+
+    local *FH;
+    open FH, "$Base$file" or return;
+    while (my $line = <FH>) {
+        chomp $line;
+        $line =~ s/#.*//;
+        next if $line =~ /^\s*$/;
+
+        if ($line =~ /^include\s+(.*?)\s*$/) {
+            my $include = $1;
+            $include = "/etc/$include" unless $include =~ m{^/};
+            foreach my $incfile (sort glob "$Base$include") {
+                $incfile =~ s{^\Q$Base\E}{} if $Base;
+                load_ldsoconf($incfile);
+            }
+            next;
+        }
+        next if $line =~ /^\s*hwcap\s/;
+
+        $line =~ s/^\s+|\s+$//g;
+        push @Ld_Library_Path, $line;
+    }
+    close FH;
+}
+
+
+# Returns ELF class and machine of the file
+sub elf_header {
+    my ($file) = @_;
+
+    local *FH;
+    open FH, $file or return;
+    binmode FH;
+    my $header;
+    my $len = read FH, $header, 20;
+    close FH;
+
+    return unless $len == 20 and substr($header, 0, 4) eq "\x7fELF";
+
+    my $class = ord substr($header, 4, 1);
+    my $machine = unpack(ord substr($header, 5, 1) == 2 ? 'n' : 'v', substr($header, 18, 2));
+
+    return ($class, $machine);
+}
+
+
+MAIN: {
+    load_ldsoconf('/etc/ld.so.conf');
+
+    my (%seen_dir, %seen, @entries);
+
+    foreach my $dir (@Ld_Library_Path, @Default_Path) {
+        next if $seen_dir{$dir}++;
+
+        local *DH;
+        opendir DH, "$Base$dir" or next;
+        my @names = sort grep { /\.so(\.[0-9.]+)?$/ } readdir DH;
+        closedir DH;
+
+        foreach my $name (@names) {
+            next unless -f "$Base$dir/$name";
+            my ($class, $machine) = elf_header("$Base$dir/$name") or next;
+            next if $seen{"$class $machine $name"}++;
+            push @entries, "$class $machine $name $dir/$name\n";
+        }
+    }
+
+    # the index is only an optimization, so ldconfig doesn't fail without it
+    local *FH;
+    if (not open FH, ">$Base$Index.new") {
+        print STDERR "fakeldconfig: $Index.new: $!\n";
+        exit 0;
+    }
+    print FH @entries;
+    if (not close FH or not rename "$Base$Index.new", "$Base$Index") {
+        print STDERR "fakeldconfig: $Index: $!\n";
+        unlink "$Base$Index.new";
+    }
+}
@@ -31,7 +31,7 @@
 #include <fcntl.h>
 
 #include "libfakechroot.h"
-#include "readlink.h"
+#include "symlink_cache.h"
 
 
 wrapper(__lxstat, int, (int ver, const char * filename, struct stat * buf))
@@ -39,9 +39,8 @@ wrapper(__lxstat, int, (int ver, const char * filename, struct stat * buf))
     char fakechroot_abspath[FAKECHROOT_PATH_MAX];
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
 
-    char tmp[FAKECHROOT_PATH_MAX];
+    struct symlink_cache_stat st;
     int retval;
-    READLINK_TYPE_RETURN linksize;
     const char* orig_filename;
 
     debug("__lxstat(%d, \"%s\", &buf)", ver, filename);
@@ -49,9 +48,10 @@ wrapper(__lxstat, int, (int ver, const char * filename, struct stat * buf))
     expand_chroot_path(filename);
     retval = nextcall(__lxstat)(ver, filename, buf);
     /* deal with http://bugs.debian.org/561991 */
-    if ((retval == 0) && (buf->st_mode & S_IFMT) == S_IFLNK)
-        if ((linksize = readlink(orig_filename, tmp, sizeof(tmp)-1)) != -1)
-            buf->st_size = linksize;
+    if ((retval == 0) && (buf->st_mode & S_IFMT) == S_IFLNK) {
+        symlink_cache_stat_set(st, *buf);
+        buf->st_size = symlink_cache_size(orig_filename, filename, &st);
+    }
 
     return retval;
 }
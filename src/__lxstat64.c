@@ -24,12 +24,13 @@
 
 #define _LARGEFILE64_SOURCE
 #define _XOPEN_SOURCE 500
+#define _DEFAULT_SOURCE
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
 
 #include "libfakechroot.h"
-#include "readlink.h"
+#include "symlink_cache.h"
 
 
 LOCAL int __lxstat64_rel(int, const char *, struct stat64 *);
@@ -54,9 +55,8 @@ LOCAL int __lxstat64_rel(int ver, const char * filename, struct stat64 * buf)
 {
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
 
-    char tmp[FAKECHROOT_PATH_MAX];
+    struct symlink_cache_stat st;
     int retval;
-    READLINK_TYPE_RETURN linksize;
     const char *orig_filename;
 
     debug("__lxstat64_rel(%d, \"%s\", &buf)", ver, filename);
@@ -64,9 +64,10 @@ LOCAL int __lxstat64_rel(int ver, const char * filename, struct stat64 * buf)
     expand_chroot_rel_path(filename);
     retval = nextcall(__lxstat64)(ver, filename, buf);
     /* deal with http://bugs.debian.org/561991 */
-    if ((retval == 0) && (buf->st_mode & S_IFMT) == S_IFLNK)
-        if ((linksize = readlink(orig_filename, tmp, sizeof(tmp)-1)) != -1)
-            buf->st_size = linksize;
+    if ((retval == 0) && (buf->st_mode & S_IFMT) == S_IFLNK) {
+        symlink_cache_stat_set(st, *buf);
+        buf->st_size = symlink_cache_size(orig_filename, filename, &st);
+    }
 
     return retval;
 }
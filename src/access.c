@@ -21,6 +21,7 @@
 #include <config.h>
 
 #include "libfakechroot.h"
+#include "direct_syscall.h"
 
 
 wrapper(access, int, (const char * pathname, int mode))
@@ -29,5 +30,5 @@ wrapper(access, int, (const char * pathname, int mode))
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
     debug("access(\"%s\", %d)", pathname, mode);
     expand_chroot_path(pathname);
-    return nextcall(access)(pathname, mode);
+    return nextsyscall(access)(pathname, mode);
 }
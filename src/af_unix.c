@@ -0,0 +1,295 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+/*
+ * Maps the paths of unix sockets.  The path is prefixed with
+ * FAKECHROOT_AF_UNIX_PATH or translated like other paths.  If the result
+ * doesn't fit into sun_path, the directory of the socket is opened and
+ * the socket is reached through /proc/self/fd/N/name instead.
+ *
+ * The kernel reports the address given to bind(), so the fake path of
+ * the socket bound through /proc is remembered by the descriptor and
+ * getsockname() returns it.  Abstract sockets are
+ * passed untouched.
+ */
+
+#include <config.h>
+
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef AF_UNIX
+
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libfakechroot.h"
+#include "direct_syscall.h"
+#include "open.h"
+#include "strlcpy.h"
+#include "af_unix.h"
+
+#ifndef O_PATH
+# define O_PATH O_RDONLY
+#endif
+
+
+#define AF_UNIX_CACHE_SIZE 1024
+#define AF_UNIX_PROC_FD "/proc/self/fd/"
+
+struct af_unix_entry {
+    dev_t dev;
+    ino_t ino;
+    /* the fake path and the path given to the kernel, one after another */
+    char * path;
+    char * mapped;
+};
+
+static struct af_unix_entry af_unix_cache[AF_UNIX_CACHE_SIZE];
+static volatile int af_unix_spinlock = 0;
+
+
+/*
+   If the lock can't be taken, remember() drops the record and narrow()
+   falls back to FAKECHROOT_AF_UNIX_PATH, so a signal handler or a child
+   after fork() never hangs.
+*/
+#define af_unix_lock() fakechroot_lock(&af_unix_spinlock)
+#define af_unix_unlock() __sync_lock_release(&af_unix_spinlock)
+
+
+/*
+   Translates the address for bind() or connect().  Returns 1 if the
+   address should be passed unchanged, 0 if newaddr should be used and -1
+   on error.  If *dirfd is not -1 after the call, it is the directory of
+   the socket opened for /proc/self/fd/N and it has to be closed.
+*/
+LOCAL int af_unix_translate(const struct sockaddr_un * addr, socklen_t addrlen, struct sockaddr_un * newaddr, socklen_t * newaddrlen, int * dirfd)
+{
+    char fakechroot_abspath[FAKECHROOT_PATH_MAX];
+    char fakechroot_buf[FAKECHROOT_PATH_MAX];
+    char orig[sizeof(addr->sun_path) + 1];
+    char tmp[FAKECHROOT_PATH_MAX];
+    const char * af_unix_path;
+    const char * path = orig;
+    const char * name;
+    size_t len;
+
+    *dirfd = -1;
+
+    /* Nothing to do for abstract sockets */
+    if (addrlen <= offsetof(struct sockaddr_un, sun_path) || addr->sun_family != AF_UNIX || addr->sun_path[0] == '\0') {
+        return 1;
+    }
+
+    /* sun_path doesn't need to be terminated */
+    len = addrlen - offsetof(struct sockaddr_un, sun_path);
+    if (len > sizeof(addr->sun_path)) {
+        len = sizeof(addr->sun_path);
+    }
+    memcpy(orig, addr->sun_path, len);
+    orig[len] = '\0';
+
+    if ((af_unix_path = getenv("FAKECHROOT_AF_UNIX_PATH")) != NULL) {
+        snprintf(tmp, sizeof(tmp), "%s/%s", af_unix_path, orig);
+        path = tmp;
+    }
+    else {
+        expand_chroot_path(path);
+    }
+
+    memset(newaddr, 0, sizeof(struct sockaddr_un));
+    newaddr->sun_family = AF_UNIX;
+
+    if (strlen(path) < sizeof(newaddr->sun_path)) {
+        strlcpy(newaddr->sun_path, path, sizeof(newaddr->sun_path));
+        *newaddrlen = SUN_LEN(newaddr);
+        return 0;
+    }
+
+    /* Too long: go through the opened directory */
+    if ((name = strrchr(path, '/')) != NULL) {
+        char dir[FAKECHROOT_PATH_MAX];
+        size_t dirlen = name == path ? 1 : (size_t)(name - path);
+        if (dirlen >= sizeof(dir)) {
+            __set_errno(ENAMETOOLONG);
+            return -1;
+        }
+        memcpy(dir, path, dirlen);
+        dir[dirlen] = '\0';
+        name++;
+        *dirfd = nextsyscall(open)(dir, O_PATH | O_DIRECTORY | O_CLOEXEC, 0);
+    }
+    else {
+        name = path;
+        *dirfd = nextsyscall(open)(".", O_PATH | O_DIRECTORY | O_CLOEXEC, 0);
+    }
+    if (*dirfd == -1) {
+        return -1;
+    }
+
+    if (snprintf(newaddr->sun_path, sizeof(newaddr->sun_path), AF_UNIX_PROC_FD "%d/%s", *dirfd, name) >= (int)sizeof(newaddr->sun_path)) {
+        close(*dirfd);
+        *dirfd = -1;
+        __set_errno(ENAMETOOLONG);
+        return -1;
+    }
+    *newaddrlen = SUN_LEN(newaddr);
+
+    debug("af_unix_translate(\"%s\") = \"%s\"", orig, newaddr->sun_path);
+    return 0;
+}
+
+
+/* Remembers the fake path of the socket bound through /proc/self/fd */
+LOCAL void af_unix_remember(int sockfd, const struct sockaddr_un * addr, socklen_t addrlen, const struct sockaddr_un * newaddr)
+{
+    struct stat st;
+    size_t len, pathlen, mappedlen;
+    char * newpath, * oldpath;
+
+    if (sockfd < 0 || sockfd >= AF_UNIX_CACHE_SIZE) {
+        return;
+    }
+
+    if (strncmp(newaddr->sun_path, AF_UNIX_PROC_FD, sizeof(AF_UNIX_PROC_FD) - 1) != 0) {
+        /* forget an older entry for this descriptor */
+        if (af_unix_cache[sockfd].path == NULL) {
+            return;
+        }
+        newpath = NULL;
+    }
+    else {
+        if (fstat(sockfd, &st) == -1) {
+            return;
+        }
+
+        len = addrlen - offsetof(struct sockaddr_un, sun_path);
+        if (len > sizeof(addr->sun_path)) {
+            len = sizeof(addr->sun_path);
+        }
+        pathlen = strnlen(addr->sun_path, len);
+        mappedlen = strlen(newaddr->sun_path);
+
+        if ((newpath = malloc(pathlen + 1 + mappedlen + 1)) == NULL) {
+            return;
+        }
+        memcpy(newpath, addr->sun_path, pathlen);
+        newpath[pathlen] = '\0';
+        memcpy(newpath + pathlen + 1, newaddr->sun_path, mappedlen + 1);
+    }
+
+    if (!af_unix_lock()) {
+        free(newpath);
+        return;
+    }
+    oldpath = af_unix_cache[sockfd].path;
+    if (newpath != NULL) {
+        af_unix_cache[sockfd].dev = st.st_dev;
+        af_unix_cache[sockfd].ino = st.st_ino;
+        af_unix_cache[sockfd].mapped = newpath + pathlen + 1;
+    }
+    af_unix_cache[sockfd].path = newpath;
+    af_unix_unlock();
+
+    free(oldpath);
+}
+
+
+/*
+   Narrows the address returned by getsockname(), getpeername(),
+   recvfrom() or recvmsg().  size is the size of the buffer given by the
+   caller.  sockfd is -1 if the address doesn't belong to this socket.
+*/
+LOCAL void af_unix_narrow(int sockfd, struct sockaddr_un * addr, socklen_t size, socklen_t * addrlen)
+{
+    char tmp[FAKECHROOT_PATH_MAX];
+    const char * af_unix_path;
+    size_t path_max = size - offsetof(struct sockaddr_un, sun_path);
+    size_t len;
+    int found = 0;
+
+    if (path_max > size) {
+        /* underflow, addr does not have space for the path */
+        return;
+    }
+    if (path_max > sizeof(addr->sun_path)) {
+        path_max = sizeof(addr->sun_path);
+    }
+
+    /* The kernel returns the full length even if it was truncated */
+    if (*addrlen <= offsetof(struct sockaddr_un, sun_path) || addr->sun_path[0] == '\0') {
+        return;
+    }
+    len = *addrlen - offsetof(struct sockaddr_un, sun_path);
+    if (len > path_max) {
+        len = path_max;
+    }
+    memcpy(tmp, addr->sun_path, len);
+    tmp[len] = '\0';
+
+    if (strncmp(tmp, AF_UNIX_PROC_FD, sizeof(AF_UNIX_PROC_FD) - 1) == 0 &&
+        sockfd >= 0 && sockfd < AF_UNIX_CACHE_SIZE && af_unix_cache[sockfd].path != NULL) {
+        struct stat st;
+        if (fstat(sockfd, &st) == 0 && af_unix_lock()) {
+            if (af_unix_cache[sockfd].path != NULL && af_unix_cache[sockfd].dev == st.st_dev &&
+                af_unix_cache[sockfd].ino == st.st_ino && strcmp(af_unix_cache[sockfd].mapped, tmp) == 0) {
+                strlcpy(tmp, af_unix_cache[sockfd].path, sizeof(tmp));
+                found = 1;
+            }
+            af_unix_unlock();
+        }
+    }
+
+    if (!found) {
+        if ((af_unix_path = getenv("FAKECHROOT_AF_UNIX_PATH")) != NULL) {
+            size_t prefixlen = strlen(af_unix_path);
+            if (strncmp(tmp, af_unix_path, prefixlen) == 0 && tmp[prefixlen] == '/') {
+                memmove(tmp, tmp + prefixlen + 1, strlen(tmp + prefixlen + 1) + 1);
+            }
+        }
+        else {
+            narrow_chroot_path(tmp);
+        }
+    }
+
+    strlcpy(addr->sun_path, tmp, path_max);
+    *addrlen = offsetof(struct sockaddr_un, sun_path) + strlen(tmp);
+}
+
+/* The lock could be held by a thread which doesn't exist in the child,
+   in the middle of a change, so the cache is dropped */
+LOCAL void af_unix_fork_child(void)
+{
+    if (af_unix_spinlock) {
+        memset(af_unix_cache, 0, sizeof(af_unix_cache));
+        af_unix_unlock();
+    }
+}
+
+#else
+typedef int empty_translation_unit;
+#endif
@@ -0,0 +1,32 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+#ifndef __AF_UNIX_H
+#define __AF_UNIX_H
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+int af_unix_translate(const struct sockaddr_un *, socklen_t, struct sockaddr_un *, socklen_t *, int *);
+void af_unix_remember(int, const struct sockaddr_un *, socklen_t, const struct sockaddr_un *);
+void af_unix_narrow(int, struct sockaddr_un *, socklen_t, socklen_t *);
+void af_unix_fork_child(void);
+
+#endif
@@ -30,10 +30,10 @@
 
 #include <sys/un.h>
 #include <errno.h>
-#include <stdio.h>
+#include <unistd.h>
 
 #include "libfakechroot.h"
-#include "strlcpy.h"
+#include "af_unix.h"
 
 #ifdef HAVE_BIND_TYPE_ARG2___CONST_SOCKADDR_ARG__
 # define SOCKADDR_UN(addr) ((addr).__sockaddr_un__)
@@ -44,41 +44,29 @@
 
 wrapper(bind, int, (int sockfd, BIND_TYPE_ARG2(addr), socklen_t addrlen))
 {
-    char fakechroot_abspath[FAKECHROOT_PATH_MAX];
-    char fakechroot_buf[FAKECHROOT_PATH_MAX];
     struct sockaddr_un *addr_un = (struct sockaddr_un *)SOCKADDR_UN(addr);
-    char tmp[FAKECHROOT_PATH_MAX];
+    struct sockaddr_un newaddr_un;
+    socklen_t newaddrlen;
+    int dirfd, status, saved_errno;
 
     debug("bind(%d, &addr, &addrlen)", sockfd);
 
-    if (addr_un->sun_family == AF_UNIX && addr_un->sun_path && *(addr_un->sun_path)) {
-        socklen_t newaddrlen;
-        struct sockaddr_un newaddr_un;
-
-        const char *af_unix_path = getenv("FAKECHROOT_AF_UNIX_PATH");
-        const int af_unix_path_max = sizeof(addr_un->sun_path);
-        const char *path = addr_un->sun_path;
-
-        if (af_unix_path != NULL) {
-            tmp[af_unix_path_max + 1] = '\0';
-            snprintf(tmp, af_unix_path_max + 1, "%s/%s", af_unix_path, path);
-            path = tmp;
-        }
-        else {
-            expand_chroot_path(path);
-        }
-
-        if (strlen(path) >= af_unix_path_max) {
-            __set_errno(ENAMETOOLONG);
-            return -1;
-        }
-        memset(&newaddr_un, 0, sizeof(struct sockaddr_un));
-        newaddr_un.sun_family = addr_un->sun_family;
-        strlcpy(newaddr_un.sun_path, path, sizeof(newaddr_un.sun_path));
-        newaddrlen = SUN_LEN(&newaddr_un);
-        return nextcall(bind)(sockfd, (struct sockaddr *)&newaddr_un, newaddrlen);
+    switch (af_unix_translate(addr_un, addrlen, &newaddr_un, &newaddrlen, &dirfd)) {
+    case 1:
+        return nextcall(bind)(sockfd, addr, addrlen);
+    case -1:
+        return -1;
     }
-    return nextcall(bind)(sockfd, addr, addrlen);
+
+    status = nextcall(bind)(sockfd, (struct sockaddr *)&newaddr_un, newaddrlen);
+    saved_errno = errno;
+    if (dirfd != -1)
+        close(dirfd);
+
+    if (status == 0)
+        af_unix_remember(sockfd, addr_un, addrlen, &newaddr_un);
+    __set_errno(saved_errno);
+    return status;
 }
 
 #else
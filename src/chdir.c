@@ -22,6 +22,7 @@
 
 #include <string.h>
 #include "libfakechroot.h"
+#include "direct_syscall.h"
 #include "getcwd_real.h"
 
 
@@ -48,5 +49,5 @@ wrapper(chdir, int, (const char * path))
         }
     }
 
-    return nextcall(chdir)(path);
+    return nextsyscall(chdir)(path);
 }
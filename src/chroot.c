@@ -44,14 +44,145 @@
 
 #include "getcwd_real.h"
 
+
+#define LIBRARY_PATH_LIST_SIZE 100
+
+struct library_path_entry {
+    const char *dir;
+    size_t len;
+};
+
+
+/* Splits the colon separated list; returns the new number of elements */
+static int library_path_split (const char *s, struct library_path_entry *list, int n)
+{
+    const char *end;
+
+    while (n < LIBRARY_PATH_LIST_SIZE) {
+        for (end = s; *end != ':' && *end != '\0'; end++);
+        if (end > s) {
+            list[n].dir = s;
+            list[n++].len = end - s;
+        }
+        if (*end == '\0') break;
+        s = end + 1;
+    }
+    return n;
+}
+
+
+static int library_path_find (const struct library_path_entry *list, int n, const char *dir, size_t len)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (list[i].len == len && memcmp(list[i].dir, dir, len) == 0) return 1;
+    }
+    return 0;
+}
+
+
+/* Checks if the colon separated list of given length contains the directory */
+static int library_path_contains (const char *list, size_t list_len, const char *dir, size_t len)
+{
+    const char *s = list, *end = list + list_len, *sep;
+
+    while (s < end) {
+        for (sep = s; sep < end && *sep != ':'; sep++);
+        if ((size_t)(sep - s) == len && memcmp(s, dir, len) == 0) return 1;
+        s = sep + 1;
+    }
+    return 0;
+}
+
+
+/*
+ * Rebuilds LD_LIBRARY_PATH for the new root: the library directories of the
+ * old root and duplicates are dropped, then the existing library directories
+ * of the new root are added once.  The library directories are /usr/lib,
+ * /lib and FAKECHROOT_EXTRA_LIBRARY_PATH, so repeated and nested chroot()
+ * calls don't make the dynamic linker probe more directories.
+ */
+static int library_path_update (const char *old_base, const char *new_base)
+{
+    struct library_path_entry subdirs[LIBRARY_PATH_LIST_SIZE];
+    dev_t added_dev[LIBRARY_PATH_LIST_SIZE];
+    ino_t added_ino[LIBRARY_PATH_LIST_SIZE];
+    int nsubdirs, nadded = 0, i, j;
+    const char *ld_library_path = getenv("LD_LIBRARY_PATH");
+    const char *extra_library_path = getenv("FAKECHROOT_EXTRA_LIBRARY_PATH");
+    const char *s, *end;
+    size_t old_base_len = strlen(old_base), new_base_len = strlen(new_base);
+    size_t len, out_len = 0, start;
+    char *out;
+    struct STAT_T sb;
+
+    if (ld_library_path == NULL) {
+        ld_library_path = "";
+    }
+    if (extra_library_path == NULL) {
+        extra_library_path = "/lib/systemd:/usr/lib/man-db";
+    }
+
+    nsubdirs = library_path_split("/usr/lib:/lib", subdirs, 0);
+    nsubdirs = library_path_split(extra_library_path, subdirs, nsubdirs);
+
+    len = strlen(ld_library_path) + 1;
+    for (i = 0; i < nsubdirs; i++) {
+        len += new_base_len + subdirs[i].len + 1;
+    }
+
+    if ((out = malloc(len)) == NULL) {
+        __set_errno(ENOMEM);
+        return -1;
+    }
+
+    for (s = ld_library_path; *s != '\0'; s = *end != '\0' ? end + 1 : end) {
+        for (end = s; *end != ':' && *end != '\0'; end++);
+        len = end - s;
+        if (len == 0) continue;
+        if (old_base_len > 0 && len > old_base_len && memcmp(s, old_base, old_base_len) == 0 &&
+            library_path_find(subdirs, nsubdirs, s + old_base_len, len - old_base_len)) continue;
+        if (library_path_contains(out, out_len, s, len)) continue;
+        if (out_len > 0) out[out_len++] = ':';
+        memcpy(out + out_len, s, len);
+        out_len += len;
+    }
+
+    for (i = 0; i < nsubdirs; i++) {
+        start = out_len > 0 ? out_len + 1 : 0;
+        memcpy(out + start, new_base, new_base_len);
+        memcpy(out + start + new_base_len, subdirs[i].dir, subdirs[i].len);
+        len = new_base_len + subdirs[i].len;
+        out[start + len] = '\0';
+
+        if (library_path_contains(out, out_len, out + start, len)) continue;
+        if (STAT(out + start, &sb) != 0 || (sb.st_mode & S_IFMT) != S_IFDIR) continue;
+        /* e.g. /lib is a symlink to /usr/lib */
+        for (j = 0; j < nadded && (added_dev[j] != sb.st_dev || added_ino[j] != sb.st_ino); j++);
+        if (j < nadded) continue;
+
+        added_dev[nadded] = sb.st_dev;
+        added_ino[nadded++] = sb.st_ino;
+        if (out_len > 0) out[out_len] = ':';
+        out_len = start + len;
+    }
+    out[out_len] = '\0';
+
+    debug("chroot LD_LIBRARY_PATH=\"%s\"", out);
+    i = setenv("LD_LIBRARY_PATH", out, 1);
+    free(out);
+
+    return i;
+}
+
 wrapper(chroot, int, (const char * path))
 {
     char fakechroot_abspath[FAKECHROOT_PATH_MAX];
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
 
-    char *ld_library_path, *separator, *new_ld_library_path;
+    char old_base[FAKECHROOT_PATH_MAX];
     int status;
-    size_t len;
     char cwd[FAKECHROOT_PATH_MAX - 1];
     char tmp[FAKECHROOT_PATH_MAX], *tmpptr = tmp;
     struct STAT_T sb;
@@ -114,30 +245,15 @@ wrapper(chroot, int, (const char * path))
         return -1;
     }
 
+    strlcpy(old_base, fakechroot_base != NULL ? fakechroot_base : "", FAKECHROOT_PATH_MAX);
+
     if (setenv("FAKECHROOT_BASE", path, 1) == -1) {
         return -1;
     }
 
-    ld_library_path = getenv("LD_LIBRARY_PATH");
-
-    if (ld_library_path != NULL && strlen(ld_library_path) > 0) {
-        separator = ":";
-    }
-    else {
-        ld_library_path = "";
-        separator = "";
-    }
-
-    len = strlen(ld_library_path)+strlen(separator)+strlen(path)*2+sizeof("/usr/lib:/lib");
-
-    if ((new_ld_library_path = malloc(len)) == NULL) {
-        __set_errno(ENOMEM);
+    if (library_path_update(old_base, path) == -1) {
         return -1;
     }
 
-    snprintf(new_ld_library_path, len, "%s%s%s/usr/lib:%s/lib", ld_library_path, separator, path, path);
-    setenv("LD_LIBRARY_PATH", new_ld_library_path, 1);
-    free(new_ld_library_path);
-
     return 0;
 }
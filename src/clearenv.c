@@ -28,6 +28,7 @@ extern char **environ;
 
 #define _GNU_SOURCE 1
 
+#include <errno.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
@@ -39,46 +40,112 @@ extern char **environ;
 
 extern int __clearenv(void);
 
+#define CLEARENV_FAKECHROOT "FAKECHROOT=true"
+
+
+/* The new environ array followed by the "NAME=VALUE" strings of the
+   preserved variables, in one block.  It is reused if the values are the
+   same as for the last call.  An old block is not freed because the
+   application could still use the strings returned by getenv().  */
+static char ** clearenv_block = NULL;
+static char * clearenv_strings = NULL;
+static size_t clearenv_block_size = 0;
+static size_t clearenv_block_count = 0;
+
+
+/* Returns non-zero if the strings of the block are the same as the
+   preserved values.  The values usually point to the block already.  */
+static int clearenv_block_eq(const char ** values, size_t n, size_t size)
+{
+    const char * p;
+    int j;
+
+    if (clearenv_block == NULL || clearenv_block_count != n || clearenv_block_size != size) {
+        return 0;
+    }
+
+    p = clearenv_strings + sizeof(CLEARENV_FAKECHROOT);
+
+    for (j = 0; j < preserve_env_list_count; j++) {
+        size_t keylen;
+        if (values[j] == NULL) {
+            continue;
+        }
+        keylen = strlen(preserve_env_list[j]);
+        if (strncmp(p, preserve_env_list[j], keylen) != 0 || p[keylen] != '=' ||
+            (p + keylen + 1 != values[j] && strcmp(p + keylen + 1, values[j]) != 0)) {
+            return 0;
+        }
+        p += keylen + 1 + strlen(values[j]) + 1;
+    }
+    return 1;
+}
+
 
 wrapper(clearenv, int, (void))
 {
-    int j, n;
-    char *key, *env;
-    char **tmpkey, **tmpenv;
+    const char ** values;
+    char ** block, ** ep;
+    char * p;
+    size_t n = 1, size;
+    int j;
 
     debug("clearenv()");
 
-    /* Preserve old environment variables */
-    tmpkey = alloca( (preserve_env_list_count + 1) * sizeof (char *) );
-    tmpenv = alloca( (preserve_env_list_count + 1) * sizeof (char *) );
-
-    for (j = 0, n = 0; j < preserve_env_list_count; j++) {
-        key = preserve_env_list[j];
-        env = getenv(key);
-        if (env != NULL) {
-            tmpkey[n] = alloca(strlen(key) + 1);
-            tmpenv[n] = alloca(strlen(env) + 1);
-            strcpy(tmpkey[n], key);
-            strcpy(tmpenv[n], env);
+    /* Measure the preserved variables */
+    values = alloca(preserve_env_list_count * sizeof(char *));
+    size = sizeof(CLEARENV_FAKECHROOT);
+    for (j = 0; j < preserve_env_list_count; j++) {
+        if ((values[j] = __getenv(preserve_env_list[j])) != NULL) {
+            size += strlen(preserve_env_list[j]) + 1 + strlen(values[j]) + 1;
             n++;
         }
     }
+    size += (n + 1) * sizeof(char *);
 
-    tmpkey[n] = NULL;
-    tmpenv[n] = NULL;
+    if (clearenv_block_eq(values, n, size)) {
+        block = clearenv_block;
+    }
+    else {
+        if ((block = malloc(size)) == NULL) {
+            __set_errno(ENOMEM);
+            return -1;
+        }
 
-    /* Clear */
-    __clearenv();
+        /* FAKECHROOT is set explicitly so environ won't be NULL */
+        p = (char *)(block + n + 1);
+        memcpy(p, CLEARENV_FAKECHROOT, sizeof(CLEARENV_FAKECHROOT));
+        p += sizeof(CLEARENV_FAKECHROOT);
+        for (j = 0; j < preserve_env_list_count; j++) {
+            size_t keylen, vallen;
+            if (values[j] == NULL) {
+                continue;
+            }
+            keylen = strlen(preserve_env_list[j]);
+            vallen = strlen(values[j]) + 1;
+            memcpy(p, preserve_env_list[j], keylen);
+            p[keylen] = '=';
+            memcpy(p + keylen + 1, values[j], vallen);
+            p += keylen + 1 + vallen;
+        }
 
-    /* Set one variable explicitly so environ won't be NULL */
-    setenv("FAKECHROOT", "true", 0);
+        clearenv_block = block;
+        clearenv_strings = (char *)(block + n + 1);
+        clearenv_block_size = size;
+        clearenv_block_count = n;
+    }
 
-    /* Recover preserved variables */
-    for (n = 0; tmpkey[n]; n++) {
-        if (setenv(tmpkey[n], tmpenv[n], 1) != 0) {
-            return -1;
-        }
+    /* The array could be changed in place since the last call */
+    p = (char *)(block + n + 1);
+    for (ep = block; ep < block + n; ep++) {
+        *ep = p;
+        p += strlen(p) + 1;
     }
+    *ep = NULL;
+
+    /* Clear and install the new environment */
+    __clearenv();
+    environ = block;
 
     return 0;
 }
@@ -0,0 +1,254 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+/*
+ * Compiled FAKECHROOT_CMD_SUBST.  The variable is parsed once into a
+ * table which is rebuilt only when the value of the variable changes.
+ *
+ * The command is a path or a shell pattern.  Plain paths are found in a
+ * hash table.  A pattern like "*\/ldconfig" matches the command in any
+ * directory and it is found in the second hash table by the last path
+ * component.
+ * Other patterns are tried with fnmatch(3), but only if they are listed
+ * before the best match found in the hash tables, because the first
+ * matching entry wins.
+ */
+
+#include <config.h>
+
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+#define _DEFAULT_SOURCE
+#include <fnmatch.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libfakechroot.h"
+#include "strchrnul.h"
+#include "strlcpy.h"
+#include "cmd_subst.h"
+
+
+struct cmd_subst_entry {
+    const char * cmd;
+    const char * subst;
+    unsigned int hash;
+};
+
+struct cmd_subst_table {
+    /* the value of the variable and its copy split in place */
+    char * orig;
+    char * env;
+    size_t envlen;
+    unsigned int mask;
+    struct cmd_subst_entry ** paths;
+    struct cmd_subst_entry ** names;
+    struct cmd_subst_entry ** patterns;
+    struct cmd_subst_entry * entries;
+};
+
+static struct cmd_subst_table * cmd_subst_table = NULL;
+static volatile int cmd_subst_spinlock = 0;
+
+
+/* If the lock is busy (i.e. in a signal handler or in a child after
+   fork()), a private table is compiled instead of waiting */
+#define cmd_subst_trylock() (!__sync_lock_test_and_set(&cmd_subst_spinlock, 1))
+#define cmd_subst_unlock() __sync_lock_release(&cmd_subst_spinlock)
+
+
+static unsigned int cmd_subst_hash(const char * s)
+{
+    unsigned int h = 5381;
+
+    while (*s)
+        h = h * 33 + (unsigned char)*s++;
+
+    return h;
+}
+
+
+static int cmd_subst_is_pattern(const char * s)
+{
+    return strpbrk(s, "*?[") != NULL;
+}
+
+
+static void cmd_subst_insert(struct cmd_subst_entry ** buckets, unsigned int mask, const char * key, struct cmd_subst_entry * e)
+{
+    unsigned int i;
+
+    e->hash = cmd_subst_hash(key);
+    for (i = e->hash & mask; buckets[i] != NULL; i = (i + 1) & mask) {
+        /* the first entry wins */
+        if (buckets[i]->hash == e->hash && strcmp(buckets[i]->cmd, e->cmd) == 0)
+            return;
+    }
+    buckets[i] = e;
+}
+
+
+static struct cmd_subst_entry * cmd_subst_find(struct cmd_subst_entry ** buckets, unsigned int mask, const char * key, size_t offset)
+{
+    unsigned int hash = cmd_subst_hash(key);
+    unsigned int i;
+
+    for (i = hash & mask; buckets[i] != NULL; i = (i + 1) & mask) {
+        if (buckets[i]->hash == hash && strcmp(buckets[i]->cmd + offset, key) == 0)
+            return buckets[i];
+    }
+    return NULL;
+}
+
+
+static struct cmd_subst_table * cmd_subst_compile(const char * env)
+{
+    struct cmd_subst_table * t;
+    struct cmd_subst_entry * e;
+    size_t envlen = strlen(env);
+    size_t count = 1, size, npatterns = 0;
+    unsigned int buckets = 1;
+    const char * s;
+    char * p, * next, * eq;
+    int last;
+
+    for (s = env; *s; s++)
+        if (*s == ':')
+            count++;
+
+    /* load factor at most 1/2 */
+    while (buckets < 2 * count)
+        buckets <<= 1;
+
+    size = sizeof(struct cmd_subst_table) + count * sizeof(struct cmd_subst_entry) +
+        (2 * buckets + count + 1) * sizeof(struct cmd_subst_entry *) + 2 * (envlen + 1);
+    if ((t = calloc(1, size)) == NULL)
+        return NULL;
+
+    t->entries = (struct cmd_subst_entry *)(t + 1);
+    t->paths = (struct cmd_subst_entry **)(t->entries + count);
+    t->names = t->paths + buckets;
+    t->patterns = t->names + buckets;
+    t->orig = (char *)(t->patterns + count + 1);
+    t->env = t->orig + envlen + 1;
+    t->envlen = envlen;
+    t->mask = buckets - 1;
+    memcpy(t->orig, env, envlen + 1);
+    memcpy(t->env, env, envlen + 1);
+
+    e = t->entries;
+    p = t->env;
+    do {
+        next = strchrnul(p, ':');
+        last = *next == '\0';
+        *next = '\0';
+        if ((eq = strchr(p, '=')) != NULL) {
+            *eq = '\0';
+            e->cmd = p;
+            e->subst = eq + 1;
+            e++;
+        }
+        p = next + 1;
+    } while (!last);
+    count = e - t->entries;
+
+    for (e = t->entries; e < t->entries + count; e++) {
+        if (e->cmd[0] == '*' && e->cmd[1] == '/' && !cmd_subst_is_pattern(e->cmd + 2) && strchr(e->cmd + 2, '/') == NULL)
+            cmd_subst_insert(t->names, t->mask, e->cmd + 2, e);
+        else if (cmd_subst_is_pattern(e->cmd))
+            t->patterns[npatterns++] = e;
+        else
+            cmd_subst_insert(t->paths, t->mask, e->cmd, e);
+    }
+
+    debug("cmd_subst_compile(): %zu entries, %zu patterns", count, npatterns);
+    return t;
+}
+
+
+static int cmd_subst_match(const struct cmd_subst_table * t, const char * filename, char * cmd_subst)
+{
+    struct cmd_subst_entry * best, * e, ** pp;
+    const char * name;
+
+    /* the entries are in order, so the lower address wins */
+    best = cmd_subst_find(t->paths, t->mask, filename, 0);
+    if ((name = strrchr(filename, '/')) != NULL &&
+        (e = cmd_subst_find(t->names, t->mask, name + 1, 2)) != NULL && (best == NULL || e < best))
+        best = e;
+    for (pp = t->patterns; *pp != NULL && (best == NULL || *pp < best); pp++) {
+        if (fnmatch((*pp)->cmd, filename, 0) == 0) {
+            best = *pp;
+            break;
+        }
+    }
+
+    if (best == NULL)
+        return 0;
+    strlcpy(cmd_subst, best->subst, FAKECHROOT_PATH_MAX);
+    return 1;
+}
+
+
+/*
+   Returns non-zero and copies the substitution for filename to cmd_subst
+   (FAKECHROOT_PATH_MAX bytes) if env has a matching entry.
+*/
+LOCAL int cmd_subst_lookup(const char * env, const char * filename, char * cmd_subst)
+{
+    struct cmd_subst_table * t, * old = NULL;
+    size_t envlen = strlen(env);
+    int ret;
+
+    if (cmd_subst_trylock()) {
+        t = cmd_subst_table;
+        if (t != NULL && t->envlen == envlen && memcmp(t->orig, env, envlen) == 0) {
+            ret = cmd_subst_match(t, filename, cmd_subst);
+            cmd_subst_unlock();
+            return ret;
+        }
+        cmd_subst_unlock();
+    }
+
+    if ((t = cmd_subst_compile(env)) == NULL)
+        return 0;
+    ret = cmd_subst_match(t, filename, cmd_subst);
+
+    if (cmd_subst_trylock()) {
+        old = cmd_subst_table;
+        cmd_subst_table = t;
+        cmd_subst_unlock();
+    }
+    else {
+        old = t;
+    }
+
+    free(old);
+    return ret;
+}
+
+
+/* The lock could be held by a thread which doesn't exist in the child,
+   in the middle of a change, so the table is compiled again */
+LOCAL void cmd_subst_fork_child(void)
+{
+    if (cmd_subst_spinlock) {
+        cmd_subst_table = NULL;
+        cmd_subst_unlock();
+    }
+}
@@ -0,0 +1,97 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+#ifndef __DIRECT_SYSCALL_H
+#define __DIRECT_SYSCALL_H
+
+#include <config.h>
+#include <fcntl.h>
+#include "libfakechroot.h"
+
+
+/*
+ * nextsyscall(function) calls the kernel directly with the already
+ * translated path if configured with --enable-direct-syscalls.  It skips
+ * the PLT hop and the libc function which could enter another wrapped
+ * function (i.e. stat() calling fstatat() in musl).  Otherwise it is the
+ * same as nextcall(function).
+ *
+ * Only 64-bit Linux is supported: there the kernel doesn't need
+ * O_LARGEFILE and struct stat of libc is the same as kernel's one.
+ */
+
+#if defined(USE_DIRECT_SYSCALLS) && defined(HAVE_SYS_SYSCALL_H) && defined(__linux__) && defined(__LP64__)
+# include <sys/syscall.h>
+# include <unistd.h>
+# define DIRECT_SYSCALLS 1
+# if defined(SYS_newfstatat) && (defined(__x86_64__) || defined(__aarch64__) || defined(__riscv))
+#  define DIRECT_SYSCALL_NEWFSTATAT 1
+# endif
+#endif
+
+
+#define nextsyscall(function) direct_##function
+
+#ifdef DIRECT_SYSCALLS
+# define direct_open(path, flags, mode) syscall(SYS_openat, AT_FDCWD, (path), (flags), (mode))
+# define direct_open64 direct_open
+# define direct_openat(dirfd, path, flags, mode) syscall(SYS_openat, (dirfd), (path), (flags), (mode))
+# define direct_openat64 direct_openat
+# define direct_readlink(path, buf, bufsiz) syscall(SYS_readlinkat, AT_FDCWD, (path), (buf), (bufsiz))
+# define direct_readlinkat(dirfd, path, buf, bufsiz) syscall(SYS_readlinkat, (dirfd), (path), (buf), (bufsiz))
+# define direct_access(path, mode) syscall(SYS_faccessat, AT_FDCWD, (path), (mode))
+/* faccessat(2) syscall has no flags argument */
+# define direct_faccessat(dirfd, path, mode, flags) \
+    ((flags) == 0 ? syscall(SYS_faccessat, (dirfd), (path), (mode)) : nextcall(faccessat)((dirfd), (path), (mode), (flags)))
+# define direct_mkdir(path, mode) syscall(SYS_mkdirat, AT_FDCWD, (path), (mode))
+# define direct_mkdirat(dirfd, path, mode) syscall(SYS_mkdirat, (dirfd), (path), (mode))
+# define direct_unlink(path) syscall(SYS_unlinkat, AT_FDCWD, (path), 0)
+# define direct_unlinkat(dirfd, path, flags) syscall(SYS_unlinkat, (dirfd), (path), (flags))
+# define direct_rmdir(path) syscall(SYS_unlinkat, AT_FDCWD, (path), AT_REMOVEDIR)
+# define direct_chdir(path) syscall(SYS_chdir, (path))
+#else
+# define direct_open nextcall(open)
+# define direct_open64 nextcall(open64)
+# define direct_openat nextcall(openat)
+# define direct_openat64 nextcall(openat64)
+# define direct_readlink nextcall(readlink)
+# define direct_readlinkat nextcall(readlinkat)
+# define direct_access nextcall(access)
+# define direct_faccessat nextcall(faccessat)
+# define direct_mkdir nextcall(mkdir)
+# define direct_mkdirat nextcall(mkdirat)
+# define direct_unlink nextcall(unlink)
+# define direct_unlinkat nextcall(unlinkat)
+# define direct_rmdir nextcall(rmdir)
+# define direct_chdir nextcall(chdir)
+#endif
+
+#ifdef DIRECT_SYSCALL_NEWFSTATAT
+# define direct_stat(path, buf) syscall(SYS_newfstatat, AT_FDCWD, (path), (buf), 0)
+# define direct_stat64 direct_stat
+# define direct_lstat(path, buf) syscall(SYS_newfstatat, AT_FDCWD, (path), (buf), AT_SYMLINK_NOFOLLOW)
+# define direct_lstat64 direct_lstat
+#else
+# define direct_stat nextcall(stat)
+# define direct_stat64 nextcall(stat64)
+# define direct_lstat nextcall(lstat)
+# define direct_lstat64 nextcall(lstat64)
+#endif
+
+#endif
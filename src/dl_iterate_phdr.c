@@ -17,6 +17,14 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+/*
+ * The callback and its data are passed to the real function in a context
+ * on the stack, so concurrent calls don't share any state.
+ *
+ * The name given by the loader is not modified: the callback gets a copy
+ * of dl_phdr_info with the narrowed name from the cache of
+ * dl_name_cache.c.
+ */
 
 #include <config.h>
 
@@ -24,27 +32,58 @@
 
 #define _GNU_SOURCE
 #include <link.h>
+#include <string.h>
 
 #include "libfakechroot.h"
+#include "dl_iterate_phdr.h"
+#include "dl_name_cache.h"
 
 
 #define DL_ITERATE_PHDR_CALLBACK_ARGS struct dl_phdr_info * info, size_t size, void * data
 
-static int (* dl_iterate_phdr_callback_saved)(DL_ITERATE_PHDR_CALLBACK_ARGS);
+struct dl_iterate_phdr_context {
+    int (* callback)(DL_ITERATE_PHDR_CALLBACK_ARGS);
+    void * data;
+    const char * base;
+};
+
 
 static int dl_iterate_phdr_callback(DL_ITERATE_PHDR_CALLBACK_ARGS)
 {
-    if (info->dlpi_name) {
-        narrow_chroot_path(info->dlpi_name);
+    struct dl_iterate_phdr_context * context = data;
+    struct dl_phdr_info newinfo;
+    const char * name;
+
+    /* The main program has an empty name */
+    if (info->dlpi_name == NULL || info->dlpi_name[0] == '\0' || context->base == NULL) {
+        return context->callback(info, size, context->data);
+    }
+
+    /* The structure is newer than ours and can't be copied */
+    if (size > sizeof(newinfo)) {
+        return context->callback(info, size, context->data);
     }
-    return dl_iterate_phdr_callback_saved(info, size, data);
+
+    name = dl_name_cache_narrow(dl_name_cache_fbase(info), info->dlpi_name);
+    if (name == info->dlpi_name) {
+        return context->callback(info, size, context->data);
+    }
+
+    memcpy(&newinfo, info, size);
+    newinfo.dlpi_name = name;
+    return context->callback(&newinfo, size, context->data);
 }
 
+
 wrapper(dl_iterate_phdr, int, (int (* callback)(DL_ITERATE_PHDR_CALLBACK_ARGS), void * data))
 {
+    struct dl_iterate_phdr_context context;
+
     debug("dl_iterate_phdr(&callback, 0x%x)", data);
-    dl_iterate_phdr_callback_saved = callback;
-    return nextcall(dl_iterate_phdr)(dl_iterate_phdr_callback, data);
+    context.callback = callback;
+    context.data = data;
+    context.base = __getenv("FAKECHROOT_BASE");
+    return nextcall(dl_iterate_phdr)(dl_iterate_phdr_callback, &context);
 }
 
 #else
@@ -0,0 +1,308 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+/*
+ * The narrowed names of the loaded modules for dladdr() and
+ * dl_iterate_phdr().  An entry is keyed by the start of the mapping of the
+ * module and the name given by the loader, which is never modified.  The
+ * entry owns a copy of both names, so the narrowed name stays valid while
+ * the module is loaded, like the one of the loader.
+ *
+ * The table grows when it is half full.  Before that, the entries of the
+ * modules which are not loaded anymore are found with dl_iterate_phdr()
+ * and freed, like the loader frees the name at dlclose().
+ */
+
+#include <config.h>
+
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libfakechroot.h"
+#include "strlcpy.h"
+#include "dl_iterate_phdr.h"
+#include "dl_name_cache.h"
+
+
+#define DL_NAME_CACHE_MIN_SIZE 64
+
+struct dl_name_cache_entry {
+    const void * fbase;
+    const char * base;
+    /* the copy of the original name and the narrowed name, one after another */
+    char * orig;
+    const char * name;
+    unsigned int hash;
+    unsigned int seen;
+};
+
+static struct dl_name_cache_entry * dl_name_cache = NULL;
+static size_t dl_name_cache_size = 0;
+static size_t dl_name_cache_count = 0;
+static unsigned int dl_name_cache_generation = 0;
+static int dl_name_cache_purging = 0;
+static volatile int dl_name_cache_spinlock = 0;
+
+
+/* If the lock can't be taken, the name of the loader is returned */
+#define dl_name_cache_lock() fakechroot_lock(&dl_name_cache_spinlock)
+#define dl_name_cache_unlock() __sync_lock_release(&dl_name_cache_spinlock)
+
+
+static unsigned int dl_name_cache_hash(const void * fbase, const char * name)
+{
+    /* FNV-1a of the name and Fibonacci hashing of the page number */
+    unsigned int h = 2166136261U;
+
+    for (; *name; name++) {
+        h = (h ^ (unsigned char)*name) * 16777619U;
+    }
+    return h ^ (unsigned int)((uintptr_t)fbase >> 12) * 2654435761U;
+}
+
+
+static struct dl_name_cache_entry * dl_name_cache_find(const void * fbase, const char * base, const char * name, unsigned int hash)
+{
+    size_t i, mask = dl_name_cache_size - 1;
+
+    if (dl_name_cache == NULL) {
+        return NULL;
+    }
+    for (i = hash & mask; dl_name_cache[i].orig != NULL; i = (i + 1) & mask) {
+        if (dl_name_cache[i].hash == hash && dl_name_cache[i].fbase == fbase &&
+            dl_name_cache[i].base == base && strcmp(dl_name_cache[i].orig, name) == 0) {
+            return &dl_name_cache[i];
+        }
+    }
+    return NULL;
+}
+
+
+/* Moves the entries which are still used to a new table */
+static int dl_name_cache_resize(size_t size)
+{
+    struct dl_name_cache_entry * table, * e;
+    size_t i, mask = size - 1;
+
+    if ((table = calloc(size, sizeof(struct dl_name_cache_entry))) == NULL) {
+        return -1;
+    }
+    for (e = dl_name_cache; e < dl_name_cache + dl_name_cache_size; e++) {
+        if (e->orig == NULL) {
+            continue;
+        }
+        for (i = e->hash & mask; table[i].orig != NULL; i = (i + 1) & mask);
+        table[i] = *e;
+    }
+    free(dl_name_cache);
+    dl_name_cache = table;
+    dl_name_cache_size = size;
+    return 0;
+}
+
+
+#ifdef HAVE_DL_ITERATE_PHDR
+
+/* The start of the mapping of the module, which dladdr() gives in dli_fbase */
+LOCAL const void * dl_name_cache_fbase(const struct dl_phdr_info * info)
+{
+    uintptr_t vaddr = UINTPTR_MAX;
+    int i;
+
+    for (i = 0; i < info->dlpi_phnum; i++) {
+        if (info->dlpi_phdr[i].p_type == PT_LOAD && info->dlpi_phdr[i].p_vaddr < vaddr) {
+            vaddr = info->dlpi_phdr[i].p_vaddr;
+        }
+    }
+    if (vaddr == UINTPTR_MAX) {
+        vaddr = 0;
+    }
+    return (const void *)(info->dlpi_addr + (vaddr & ~((uintptr_t)getpagesize() - 1)));
+}
+
+
+/*
+   Marks the entries of a loaded module.  The same library loaded again
+   has the same name at another address.  Some loaders give the load
+   address in dli_fbase instead of the start of the mapping.  The main
+   program has an empty name here and argv[0] in dladdr().
+*/
+static int dl_name_cache_mark(struct dl_phdr_info * info, size_t size, void * data)
+{
+    const void * fbase = dl_name_cache_fbase(info);
+    unsigned int generation = *(unsigned int *)data;
+    struct dl_name_cache_entry * e;
+
+    (void)size;
+    if (!dl_name_cache_lock()) {
+        return 1;
+    }
+    for (e = dl_name_cache; e < dl_name_cache + dl_name_cache_size; e++) {
+        if (e->orig != NULL && (e->fbase == fbase || e->fbase == (const void *)info->dlpi_addr) &&
+            (info->dlpi_name[0] == '\0' || strcmp(e->orig, info->dlpi_name) == 0)) {
+            e->seen = generation;
+        }
+    }
+    dl_name_cache_unlock();
+    return 0;
+}
+
+
+/* Frees the entries of the modules which are not loaded anymore */
+static void dl_name_cache_purge(void)
+{
+    struct dl_name_cache_entry * e;
+    unsigned int generation;
+    int complete;
+
+    if (!dl_name_cache_lock()) {
+        return;
+    }
+    if (dl_name_cache_purging) {
+        dl_name_cache_unlock();
+        return;
+    }
+    dl_name_cache_purging = 1;
+    generation = ++dl_name_cache_generation;
+    dl_name_cache_unlock();
+
+    /* The loader calls back with its own lock, so ours is not held here */
+    complete = nextcall(dl_iterate_phdr)(dl_name_cache_mark, &generation) == 0;
+
+    /* The flag must be cleared, so wait for the lock */
+    while (!dl_name_cache_lock()) {
+        continue;
+    }
+    /* The entries found or added since the start are marked too */
+    for (e = dl_name_cache; complete && e < dl_name_cache + dl_name_cache_size; e++) {
+        if (e->orig != NULL && e->seen != generation) {
+            free(e->orig);
+            e->orig = NULL;
+            dl_name_cache_count--;
+        }
+    }
+    if (complete) {
+        dl_name_cache_resize(dl_name_cache_size);
+    }
+    dl_name_cache_purging = 0;
+    dl_name_cache_unlock();
+}
+
+#endif
+
+
+/*
+   Returns the narrowed name of the module loaded at fbase with the name
+   given by the loader.  The name of the loader is returned if it can't be
+   cached.
+*/
+LOCAL const char * dl_name_cache_narrow(const void * fbase, const char * name)
+{
+    char buf[FAKECHROOT_PATH_MAX];
+    const char * base = __getenv("FAKECHROOT_BASE");
+    const char * ret = NULL;
+    struct dl_name_cache_entry * e;
+    unsigned int hash;
+    size_t i, origlen;
+    int full = 0;
+    char * copy;
+
+    if (base == NULL || name == NULL || name[0] != '/') {
+        return name;
+    }
+
+    hash = dl_name_cache_hash(fbase, name);
+
+    if (!dl_name_cache_lock()) {
+        return name;
+    }
+    if ((e = dl_name_cache_find(fbase, base, name, hash)) != NULL) {
+        e->seen = dl_name_cache_generation;
+        ret = e->name;
+    }
+    else {
+        full = dl_name_cache_size > 0 && 2 * (dl_name_cache_count + 1) > dl_name_cache_size;
+    }
+    dl_name_cache_unlock();
+
+    if (ret != NULL) {
+        return ret;
+    }
+
+    strlcpy(buf, name, sizeof(buf));
+    narrow_chroot_path(buf);
+
+    origlen = strlen(name);
+    if ((copy = malloc(origlen + 1 + strlen(buf) + 1)) == NULL) {
+        return name;
+    }
+    memcpy(copy, name, origlen + 1);
+    strcpy(copy + origlen + 1, buf);
+
+#ifdef HAVE_DL_ITERATE_PHDR
+    if (full) {
+        dl_name_cache_purge();
+    }
+#endif
+
+    /* Another thread could add the same entry in the meantime */
+    if (!dl_name_cache_lock()) {
+        free(copy);
+        return name;
+    }
+    if ((e = dl_name_cache_find(fbase, base, name, hash)) != NULL) {
+        e->seen = dl_name_cache_generation;
+        ret = e->name;
+    }
+    else if (2 * (dl_name_cache_count + 1) <= dl_name_cache_size ||
+             dl_name_cache_resize(dl_name_cache_size ? 2 * dl_name_cache_size : DL_NAME_CACHE_MIN_SIZE) == 0) {
+        for (i = hash & (dl_name_cache_size - 1); dl_name_cache[i].orig != NULL; i = (i + 1) & (dl_name_cache_size - 1));
+        e = &dl_name_cache[i];
+        e->fbase = fbase;
+        e->base = base;
+        e->orig = copy;
+        e->name = copy + origlen + 1;
+        e->hash = hash;
+        e->seen = dl_name_cache_generation;
+        dl_name_cache_count++;
+        ret = e->name;
+        copy = NULL;
+    }
+    dl_name_cache_unlock();
+
+    free(copy);
+    return ret != NULL ? ret : name;
+}
+
+
+/* The lock could be held by a thread which doesn't exist in the child,
+   in the middle of a change, so the cache is dropped */
+LOCAL void dl_name_cache_fork_child(void)
+{
+    if (dl_name_cache_spinlock) {
+        dl_name_cache = NULL;
+        dl_name_cache_size = 0;
+        dl_name_cache_count = 0;
+        dl_name_cache_unlock();
+    }
+    dl_name_cache_purging = 0;
+}
@@ -0,0 +1,35 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+#ifndef __DL_NAME_CACHE_H
+#define __DL_NAME_CACHE_H
+
+#include <config.h>
+
+#ifdef HAVE_DL_ITERATE_PHDR
+# include <link.h>
+#endif
+
+const char * dl_name_cache_narrow(const void *, const char *);
+#ifdef HAVE_DL_ITERATE_PHDR
+const void * dl_name_cache_fbase(const struct dl_phdr_info *);
+#endif
+void dl_name_cache_fork_child(void);
+
+#endif
@@ -17,6 +17,10 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+/*
+ * The narrowed file name is kept in the cache of dl_name_cache.c, so the
+ * name given by the loader is not modified.
+ */
 
 #include <config.h>
 
@@ -26,6 +30,7 @@
 #include <dlfcn.h>
 
 #include "libfakechroot.h"
+#include "dl_name_cache.h"
 
 
 wrapper(dladdr, int, (const void * addr, Dl_info * info))
@@ -36,11 +41,9 @@ wrapper(dladdr, int, (const void * addr, Dl_info * info))
 
     ret = nextcall(dladdr)(addr, info);
 
-    if (info->dli_fname) {
-        narrow_chroot_path(info->dli_fname);
-    }
-    if (info->dli_sname) {
-        narrow_chroot_path(info->dli_sname);
+    /* dli_sname is the name of the symbol, not a path */
+    if (ret != 0 && info->dli_fname != NULL && info->dli_fname[0] != '\0') {
+        info->dli_fname = dl_name_cache_narrow(info->dli_fbase, info->dli_fname);
     }
 
     return ret;
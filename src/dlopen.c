@@ -23,16 +23,34 @@
 
 #include <string.h>
 #include "libfakechroot.h"
+#include "library_index.h"
 
 
 wrapper(dlopen, void *, (const char * filename, int flag))
 {
     char fakechroot_abspath[FAKECHROOT_PATH_MAX];
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
+    char indexed[FAKECHROOT_PATH_MAX];
+    const char *path;
+    void *handle;
+
     debug("dlopen(\"%s\", %d)", filename, flag);
     if (filename && strchr(filename, '/') != NULL) {
         expand_chroot_path(filename);
         debug("dlopen(\"%s\", %d)", filename, flag);
+        return nextcall(dlopen)(filename, flag);
+    }
+    if ((handle = nextcall(dlopen)(filename, flag)) != NULL || filename == NULL) {
+        return handle;
+    }
+    /* the index is used after LD_LIBRARY_PATH, RPATH and RUNPATH like ld.so.cache */
+    if ((path = library_index_lookup(filename, indexed, FAKECHROOT_PATH_MAX)) != NULL) {
+        expand_chroot_path(path);
+        if ((handle = nextcall(dlopen)(path, flag)) != NULL) {
+            return handle;
+        }
+        /* dlerror() reports the name given by the caller */
+        return nextcall(dlopen)(filename, flag);
     }
-    return nextcall(dlopen)(filename, flag);
+    return NULL;
 }
@@ -28,6 +28,9 @@
 #endif
 #include <stdlib.h>
 #include <fcntl.h>
+#ifdef HAVE_ELF_H
+# include <elf.h>
+#endif
 #include "strchrnul.h"
 #include "libfakechroot.h"
 #include "open.h"
@@ -35,6 +38,37 @@
 #include "readlink.h"
 
 
+#ifdef HAVE_ELF_H
+/* Statically linked ELF has no PT_INTERP and can't be wrapped by preloading */
+#define is_static_elf_class(Ehdr, Phdr) \
+    { \
+        const Ehdr *ehdr = (const Ehdr *)(buf); \
+        unsigned int phi; \
+        if ((ehdr->e_type != ET_EXEC && ehdr->e_type != ET_DYN) || \
+                ehdr->e_phentsize != sizeof(Phdr) || \
+                ehdr->e_phoff + (size_t)ehdr->e_phnum * sizeof(Phdr) > (len)) \
+            return 0; \
+        for (phi = 0; phi < ehdr->e_phnum; phi++) { \
+            const Phdr *phdr = (const Phdr *)((buf) + ehdr->e_phoff + phi * sizeof(Phdr)); \
+            if (phdr->p_type == PT_INTERP) \
+                return 0; \
+        } \
+        return 1; \
+    }
+
+static int is_static_elf (const char * buf, size_t len)
+{
+    if (len < EI_NIDENT || memcmp(buf, ELFMAG, SELFMAG) != 0)
+        return 0;
+    if (buf[EI_CLASS] == ELFCLASS64 && len >= sizeof(Elf64_Ehdr))
+        is_static_elf_class(Elf64_Ehdr, Elf64_Phdr);
+    if (buf[EI_CLASS] == ELFCLASS32 && len >= sizeof(Elf32_Ehdr))
+        is_static_elf_class(Elf32_Ehdr, Elf32_Phdr);
+    return 0;
+}
+#endif
+
+
 wrapper(execve, int, (const char * filename, char * const argv [], char * const envp []))
 {
     char fakechroot_abspath[FAKECHROOT_PATH_MAX];
@@ -53,6 +87,7 @@ wrapper(execve, int, (const char * filename, char * const argv [], char * const
     char substfilename[FAKECHROOT_PATH_MAX];
     char newfilename[FAKECHROOT_PATH_MAX];
     char argv0[FAKECHROOT_PATH_MAX];
+    char exeenv[sizeof("FAKECHROOT_EXE=") + FAKECHROOT_PATH_MAX];
     unsigned int i, j, n, newenvppos;
     unsigned int do_cmd_subst = 0;
     size_t sizeenvp;
@@ -62,8 +97,10 @@ wrapper(execve, int, (const char * filename, char * const argv [], char * const
 
     char *elfloader = getenv("FAKECHROOT_ELFLOADER");
     char *elfloader_opt_argv0 = getenv("FAKECHROOT_ELFLOADER_OPT_ARGV0");
+    char *supervisor = getenv("FAKECHROOT_SUPERVISOR");
     if (elfloader && !*elfloader) elfloader = NULL;
     if (elfloader_opt_argv0 && !*elfloader_opt_argv0) elfloader_opt_argv0 = NULL;
+    if (supervisor && !*supervisor) supervisor = NULL;
 
     debug("execve(\"%s\", {\"%s\", ...}, {\"%s\", ...})", filename, argv[0], envp ? envp[0] : "(null)");
 
@@ -85,7 +122,7 @@ wrapper(execve, int, (const char * filename, char * const argv [], char * const
     }
 
     /* Copy envp to newenvp */
-    newenvp = malloc( (sizeenvp + preserve_env_list_count + 1) * sizeof (char *) );
+    newenvp = malloc( (sizeenvp + preserve_env_list_count + 3) * sizeof (char *) );
     if (newenvp == NULL) {
         __set_errno(ENOMEM);
         return -1;
@@ -135,6 +172,7 @@ wrapper(execve, int, (const char * filename, char * const argv [], char * const
             if ((tp = strchr(tmpkey, '=')) != NULL) {
                 *tp = 0;
                 if (strcmp(tmpkey, "FAKECHROOT") == 0 ||
+                    strcmp(tmpkey, "FAKECHROOT_EXE") == 0 ||
                     (is_base_orig && strcmp(tmpkey, "FAKECHROOT_BASE") == 0))
                 {
                     goto skip2;
@@ -188,6 +226,22 @@ wrapper(execve, int, (const char * filename, char * const argv [], char * const
 
     /* No hashbang in argv */
     if (hashbang[0] != '#' || hashbang[1] != '!') {
+#ifdef HAVE_ELF_H
+        /* Run statically linked binary via supervisor */
+        if (supervisor && is_static_elf(hashbang, i)) {
+            newargv[0] = supervisor;
+            newargv[1] = filename;
+            for (i = 0, n = 2; argv[i] != NULL && i < argv_max - 3; ) {
+                newargv[n++] = argv[i++];
+            }
+            newargv[n] = 0;
+
+            debug("nextcall(execve)(\"%s\", {\"%s\", \"%s\", ...}, {\"%s\", ...})", supervisor, newargv[0], newargv[1], newenvp[0]);
+            status = nextcall(execve)(supervisor, (char * const *)newargv, newenvp);
+            goto error;
+        }
+#endif
+
         if (!elfloader) {
             status = nextcall(execve)(filename, argv, newenvp);
             goto error;
@@ -207,6 +261,10 @@ wrapper(execve, int, (const char * filename, char * const argv [], char * const
             newargv[n++] = argv0;
         }
         newargv[n] = filename;
+        /* The kernel sees the elfloader as the executable */
+        snprintf(exeenv, sizeof(exeenv), "FAKECHROOT_EXE=%s", filename);
+        newenvp[newenvppos++] = exeenv;
+        newenvp[newenvppos] = NULL;
 
         debug("nextcall(execve)(\"%s\", {\"%s\", \"%s\", ...}, {\"%s\", ...})", elfloader, newargv[0], newargv[n], newenvp[0]);
         status = nextcall(execve)(elfloader, (char * const *)newargv, newenvp);
@@ -263,6 +321,9 @@ wrapper(execve, int, (const char * filename, char * const argv [], char * const
         newargv[n++] = argv0;
     }
     newargv[n] = newfilename;
+    snprintf(exeenv, sizeof(exeenv), "FAKECHROOT_EXE=%s", newfilename);
+    newenvp[newenvppos++] = exeenv;
+    newenvp[newenvppos] = NULL;
     debug("nextcall(execve)(\"%s\", {\"%s\", \"%s\", \"%s\", ...}, {\"%s\", ...})", elfloader, newargv[0], newargv[1], newargv[n], newenvp[0]);
     status = nextcall(execve)(elfloader, (char * const *)newargv, newenvp);
 
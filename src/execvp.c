@@ -30,6 +30,7 @@
 #include <unistd.h>
 #include "strchrnul.h"
 #include "libfakechroot.h"
+#include "path_cache.h"
 
 #ifndef __GLIBC__
 extern char **environ;
@@ -58,6 +59,7 @@ wrapper(execvp, int, (const char * file, char * const argv[]))
     } else {
         int got_eacces = 0;
         char *path, *p, *name;
+        char found[FAKECHROOT_PATH_MAX];
         size_t len;
         size_t pathlen;
 
@@ -77,6 +79,25 @@ wrapper(execvp, int, (const char * file, char * const argv[]))
 #endif
         }
 
+        /* Probe the candidates first and execute only the found one.  */
+        if (path_cache_search(file, path, found, sizeof(found)) == NULL)
+            return -1;
+
+        execve(found, argv, environ);
+
+        switch (errno) {
+        case EACCES:
+        case ENOENT:
+        case ESTALE:
+        case ENOTDIR:
+            /* The found file can't be executed (i.e. it is a directory or
+             its interpreter is missing): try every element like before.  */
+            path_cache_forget(file, path);
+            break;
+        default:
+            return -1;
+        }
+
         len = strlen(file) + 1;
         pathlen = strlen(path);
         name = alloca(pathlen + len + 1);
@@ -25,6 +25,7 @@
 #define _ATFILE_SOURCE
 #include <unistd.h>
 #include "libfakechroot.h"
+#include "direct_syscall.h"
 
 
 wrapper(faccessat, int, (int dirfd, const char * pathname, int mode, int flags))
@@ -33,7 +34,7 @@ wrapper(faccessat, int, (int dirfd, const char * pathname, int mode, int flags))
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
     debug("faccessat(%d, \"%s\", %d, %d)", dirfd, pathname, mode, flags);
     expand_chroot_path_at(dirfd, pathname);
-    return nextcall(faccessat)(dirfd, pathname, mode, flags);
+    return nextsyscall(faccessat)(dirfd, pathname, mode, flags);
 }
 
 #else
@@ -0,0 +1,930 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+/*
+ * Supervisor for statically linked binaries.
+ *
+ * Usage: fakechroot-supervisor path argv0 [arg...]
+ *
+ * The execve() wrapper runs a statically linked binary through this
+ * program when FAKECHROOT_SUPERVISOR is set.  The binary is started in a
+ * child process with a seccomp filter which turns path-taking syscalls into
+ * user notifications.  The supervisor translates the path with the rules
+ * of translate.c shared with libfakechroot, performs the syscall on behalf
+ * of the child and returns the result, injecting new descriptors with
+ * SECCOMP_IOCTL_NOTIF_ADDFD.  Paths which are already translated (calls
+ * made by preloaded processes started from the static binary) and paths
+ * which don't need translation are passed to the kernel unchanged.
+ *
+ * chdir(), chroot() and execve() can't be performed by another process
+ * and the arguments of a notified syscall can't be changed, so these fail
+ * with EPERM and a message on stderr if the path would have to be
+ * translated.
+ *
+ * The supervisor runs with umask 0 because the umask of the child is
+ * applied to the created files by hand.
+ *
+ * All path operations in this program are done with raw syscalls because
+ * the supervisor itself is usually started with libfakechroot preloaded.
+ */
+
+
+#include <config.h>
+
+#define _GNU_SOURCE
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+
+#include "libfakechroot.h"
+#include "dedotdot.h"
+#include "strlcpy.h"
+#include "translate.h"
+
+
+#if defined(__x86_64__) && !defined(__ILP32__)
+# define SUPERVISOR_AUDIT_ARCH AUDIT_ARCH_X86_64
+#elif defined(__i386__)
+# define SUPERVISOR_AUDIT_ARCH AUDIT_ARCH_I386
+#elif defined(__aarch64__)
+# define SUPERVISOR_AUDIT_ARCH AUDIT_ARCH_AARCH64
+#elif defined(__arm__) && defined(__ARMEL__)
+# define SUPERVISOR_AUDIT_ARCH AUDIT_ARCH_ARM
+#elif defined(__powerpc64__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+# define SUPERVISOR_AUDIT_ARCH AUDIT_ARCH_PPC64LE
+#elif defined(__riscv) && __riscv_xlen == 64
+# define SUPERVISOR_AUDIT_ARCH AUDIT_ARCH_RISCV64
+#endif
+
+#define ARG_NONE (-1)
+
+
+enum supervisor_op {
+    OP_OPEN,
+    OP_STAT,
+    OP_STATX,
+    OP_ACCESS,
+    OP_READLINK,
+    OP_MKDIR,
+    OP_UNLINK,
+    OP_RENAME,
+    OP_LINK,
+    OP_SYMLINK,
+    OP_CHMOD,
+    OP_CHOWN,
+    OP_TRUNCATE,
+    OP_UTIMENS,
+    OP_MKNOD,
+    OP_DENY
+};
+
+/* Syscall description: which arguments are the dirfds and the paths, and
+   the positions of the operation specific arguments.  The second path of
+   symlink() is the target, which is not a path relative to dirfd. */
+struct supervisor_syscall {
+    long nr;
+    enum supervisor_op op;
+    int dirfd_arg;
+    int path_arg;
+    int dirfd2_arg;
+    int path2_arg;
+    int arg1;
+    int arg2;
+    int arg3;
+    long fixed;
+};
+
+#define N ARG_NONE
+
+static const struct supervisor_syscall supervisor_syscalls[] = {
+#ifdef SYS_open
+    { SYS_open,       OP_OPEN,     N, 0, N, N, 1, 2, N, 0 },
+#endif
+#ifdef SYS_creat
+    { SYS_creat,      OP_OPEN,     N, 0, N, N, N, 1, N, O_CREAT|O_WRONLY|O_TRUNC },
+#endif
+    { SYS_openat,     OP_OPEN,     0, 1, N, N, 2, 3, N, 0 },
+#if defined(SYS_stat) && defined(SYS_newfstatat)
+    { SYS_stat,       OP_STAT,     N, 0, N, N, 1, N, N, 0 },
+#endif
+#if defined(SYS_lstat) && defined(SYS_newfstatat)
+    { SYS_lstat,      OP_STAT,     N, 0, N, N, 1, N, N, AT_SYMLINK_NOFOLLOW },
+#endif
+#ifdef SYS_newfstatat
+    { SYS_newfstatat, OP_STAT,     0, 1, N, N, 2, 3, N, 0 },
+#endif
+#ifdef SYS_statx
+    { SYS_statx,      OP_STATX,    0, 1, N, N, 2, 3, 4, 0 },
+#endif
+#ifdef SYS_access
+    { SYS_access,     OP_ACCESS,   N, 0, N, N, 1, N, N, 0 },
+#endif
+    { SYS_faccessat,  OP_ACCESS,   0, 1, N, N, 2, N, N, 0 },
+#ifdef SYS_faccessat2
+    { SYS_faccessat2, OP_ACCESS,   0, 1, N, N, 2, 3, N, 0 },
+#endif
+#ifdef SYS_readlink
+    { SYS_readlink,   OP_READLINK, N, 0, N, N, 1, 2, N, 0 },
+#endif
+    { SYS_readlinkat, OP_READLINK, 0, 1, N, N, 2, 3, N, 0 },
+#ifdef SYS_mkdir
+    { SYS_mkdir,      OP_MKDIR,    N, 0, N, N, 1, N, N, 0 },
+#endif
+    { SYS_mkdirat,    OP_MKDIR,    0, 1, N, N, 2, N, N, 0 },
+#ifdef SYS_unlink
+    { SYS_unlink,     OP_UNLINK,   N, 0, N, N, N, N, N, 0 },
+#endif
+#ifdef SYS_rmdir
+    { SYS_rmdir,      OP_UNLINK,   N, 0, N, N, N, N, N, AT_REMOVEDIR },
+#endif
+    { SYS_unlinkat,   OP_UNLINK,   0, 1, N, N, 2, N, N, 0 },
+#ifdef SYS_rename
+    { SYS_rename,     OP_RENAME,   N, 0, N, 1, N, N, N, 0 },
+#endif
+#ifdef SYS_renameat
+    { SYS_renameat,   OP_RENAME,   0, 1, 2, 3, N, N, N, 0 },
+#endif
+#ifdef SYS_renameat2
+    { SYS_renameat2,  OP_RENAME,   0, 1, 2, 3, 4, N, N, 0 },
+#endif
+#ifdef SYS_link
+    { SYS_link,       OP_LINK,     N, 0, N, 1, N, N, N, 0 },
+#endif
+    { SYS_linkat,     OP_LINK,     0, 1, 2, 3, 4, N, N, 0 },
+#ifdef SYS_symlink
+    { SYS_symlink,    OP_SYMLINK,  N, 1, N, 0, N, N, N, 0 },
+#endif
+    { SYS_symlinkat,  OP_SYMLINK,  1, 2, N, 0, N, N, N, 0 },
+#ifdef SYS_chmod
+    { SYS_chmod,      OP_CHMOD,    N, 0, N, N, 1, N, N, 0 },
+#endif
+    { SYS_fchmodat,   OP_CHMOD,    0, 1, N, N, 2, N, N, 0 },
+#ifdef SYS_chown
+    { SYS_chown,      OP_CHOWN,    N, 0, N, N, 1, 2, N, 0 },
+#endif
+#ifdef SYS_chown32
+    { SYS_chown32,    OP_CHOWN,    N, 0, N, N, 1, 2, N, 0 },
+#endif
+#ifdef SYS_lchown
+    { SYS_lchown,     OP_CHOWN,    N, 0, N, N, 1, 2, N, AT_SYMLINK_NOFOLLOW },
+#endif
+#ifdef SYS_lchown32
+    { SYS_lchown32,   OP_CHOWN,    N, 0, N, N, 1, 2, N, AT_SYMLINK_NOFOLLOW },
+#endif
+    { SYS_fchownat,   OP_CHOWN,    0, 1, N, N, 2, 3, 4, 0 },
+    { SYS_truncate,   OP_TRUNCATE, N, 0, N, N, 1, N, N, 0 },
+    { SYS_utimensat,  OP_UTIMENS,  0, 1, N, N, 2, 3, N, 0 },
+#ifdef SYS_mknod
+    { SYS_mknod,      OP_MKNOD,    N, 0, N, N, 1, 2, N, 0 },
+#endif
+    { SYS_mknodat,    OP_MKNOD,    0, 1, N, N, 2, 3, N, 0 },
+    { SYS_chdir,      OP_DENY,     N, 0, N, N, N, N, N, 0 },
+    { SYS_chroot,     OP_DENY,     N, 0, N, N, N, N, N, 0 },
+    { SYS_execve,     OP_DENY,     N, 0, N, N, N, N, N, 0 },
+#ifdef SYS_execveat
+    { SYS_execveat,   OP_DENY,     0, 1, N, N, N, N, N, 0 },
+#endif
+};
+
+#undef N
+
+#define SUPERVISOR_SYSCALLS_COUNT (sizeof supervisor_syscalls / sizeof supervisor_syscalls[0])
+
+
+static const char *fakechroot_base;
+static pid_t child_pid;
+
+
+LOCAL int fakechroot_debug (const char *fmt, ...)
+{
+    int ret;
+    char newfmt[2048];
+
+    va_list ap;
+    va_start(ap, fmt);
+
+    if (!getenv("FAKECHROOT_DEBUG"))
+        return 0;
+
+    snprintf(newfmt, sizeof(newfmt), "fakechroot-supervisor: %s\n", fmt);
+
+    ret = vfprintf(stderr, newfmt, ap);
+    va_end(ap);
+
+    return ret;
+}
+
+
+/* Read NUL-terminated string from the memory of the traced process */
+static int read_string (int memfd, unsigned long addr, char *buf, size_t size)
+{
+    size_t n = 0;
+
+    while (n < size) {
+        size_t chunk = 4096 - ((addr + n) & 4095);
+        ssize_t r;
+
+        if (chunk > size - n)
+            chunk = size - n;
+        if ((r = pread(memfd, buf + n, chunk, addr + n)) <= 0)
+            return -1;
+        if (memchr(buf + n, '\0', r) != NULL)
+            return 0;
+        n += r;
+    }
+
+    __set_errno(ENAMETOOLONG);
+    return -1;
+}
+
+
+/*
+ * Translate the path for the traced process.  Returns 1 if resolved holds
+ * the host path, 0 if the syscall can be passed to the kernel unchanged or
+ * -1 with errno set if the translated path is too long.
+ */
+static int translate_path (pid_t pid, int dirfd, const char *path, char *resolved)
+{
+    char abs[FAKECHROOT_PATH_MAX];
+
+    if (*path == '\0')
+        return 0;
+
+    if (*path == '/') {
+        if (translate_has_base(fakechroot_base, path))
+            return 0;
+        if (strlcpy(abs, path, sizeof(abs)) >= sizeof(abs))
+            goto too_long;
+    }
+    else {
+        char link[64], dir[FAKECHROOT_PATH_MAX];
+        long linksize;
+
+        if (dirfd == AT_FDCWD)
+            snprintf(link, sizeof(link), "/proc/%d/cwd", (int)pid);
+        else
+            snprintf(link, sizeof(link), "/proc/%d/fd/%d", (int)pid, dirfd);
+
+        if ((linksize = syscall(SYS_readlinkat, AT_FDCWD, link, dir, sizeof(dir) - 1)) == -1)
+            return 0;
+        dir[linksize] = '\0';
+
+        /* Relative to a directory outside of the chroot: the kernel knows better */
+        if (!translate_has_base(fakechroot_base, dir))
+            return 0;
+
+        translate_narrow(fakechroot_base, dir);
+        if ((size_t)snprintf(abs, sizeof(abs), "%s/%s", strcmp(dir, "/") == 0 ? "" : dir, path) >= sizeof(abs))
+            goto too_long;
+    }
+
+    dedotdot(abs);
+
+    /* /proc/self in the supervisor is not the traced process */
+    if (strncmp(abs, "/proc/self", 10) == 0 && (abs[10] == '/' || abs[10] == '\0')) {
+        char tmp[FAKECHROOT_PATH_MAX];
+        snprintf(tmp, sizeof(tmp), "/proc/%d%s", (int)pid, abs + 10);
+        strlcpy(abs, tmp, sizeof(abs));
+    }
+    else if (strncmp(abs, "/proc/thread-self", 17) == 0 && (abs[17] == '/' || abs[17] == '\0')) {
+        char tmp[FAKECHROOT_PATH_MAX];
+        snprintf(tmp, sizeof(tmp), "/proc/%d/task/%d%s", (int)pid, (int)pid, abs + 17);
+        strlcpy(abs, tmp, sizeof(abs));
+    }
+
+    if (translate_excluded(abs))
+        strlcpy(resolved, abs, FAKECHROOT_PATH_MAX);
+    else if (translate_expand(fakechroot_base, abs, resolved, FAKECHROOT_PATH_MAX) == -1)
+        goto too_long;
+
+    return strcmp(resolved, path) != 0;
+
+too_long:
+    __set_errno(ENAMETOOLONG);
+    return -1;
+}
+
+
+static const char * deny_name (long nr)
+{
+    switch (nr) {
+        case SYS_chdir:
+            return "chdir";
+        case SYS_chroot:
+            return "chroot";
+#ifdef SYS_execveat
+        case SYS_execveat:
+            return "execveat";
+#endif
+        default:
+            return "execve";
+    }
+}
+
+
+static int has_dotdot (const char *path)
+{
+    const char *p;
+
+    for (p = path; (p = strstr(p, "..")) != NULL; p += 2) {
+        if ((p == path || p[-1] == '/') && (p[2] == '/' || p[2] == '\0'))
+            return 1;
+    }
+    return 0;
+}
+
+
+/*
+ * The path which reaches the same file from the supervisor, for the
+ * syscalls with two paths when only one of them is translated.
+ */
+static void passthrough_path (pid_t pid, int dirfd, const char *path, char *resolved)
+{
+    char dir[64];
+
+    if (*path == '/') {
+        strlcpy(resolved, path, FAKECHROOT_PATH_MAX);
+        return;
+    }
+
+    if (dirfd == AT_FDCWD)
+        snprintf(dir, sizeof(dir), "/proc/%d/cwd", (int)pid);
+    else
+        snprintf(dir, sizeof(dir), "/proc/%d/fd/%d", (int)pid, dirfd);
+
+    if (*path == '\0')
+        strlcpy(resolved, dir, FAKECHROOT_PATH_MAX);
+    else
+        snprintf(resolved, FAKECHROOT_PATH_MAX, "%s/%s", dir, path);
+}
+
+
+static mode_t get_umask (pid_t pid)
+{
+    char path[64], buf[1024], *p;
+    int fd;
+    ssize_t n;
+
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    if ((fd = syscall(SYS_openat, AT_FDCWD, path, O_RDONLY|O_CLOEXEC)) == -1)
+        return 022;
+    n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0)
+        return 022;
+    buf[n] = '\0';
+    if ((p = strstr(buf, "Umask:")) == NULL)
+        return 022;
+    return (mode_t)strtoul(p + 6, NULL, 8);
+}
+
+
+static int add_fd (int listener, struct seccomp_notif_resp *resp, int fd, int flags)
+{
+    struct seccomp_notif_addfd addfd;
+    int ret;
+
+    memset(&addfd, 0, sizeof(addfd));
+    addfd.id = resp->id;
+    addfd.srcfd = fd;
+    addfd.newfd_flags = flags & O_CLOEXEC;
+
+#ifdef SECCOMP_ADDFD_FLAG_SEND
+    addfd.flags = SECCOMP_ADDFD_FLAG_SEND;
+    if ((ret = ioctl(listener, SECCOMP_IOCTL_NOTIF_ADDFD, &addfd)) >= 0)
+        return 1;
+    if (errno != EINVAL)
+        return -1;
+    addfd.flags = 0;
+#endif
+
+    if ((ret = ioctl(listener, SECCOMP_IOCTL_NOTIF_ADDFD, &addfd)) == -1)
+        return -1;
+    resp->val = ret;
+    return 0;
+}
+
+
+/* Returns 1 if the response was already sent with the descriptor */
+static int do_open (int listener, struct seccomp_notif_resp *resp, pid_t pid, const char *path, int flags, mode_t mode)
+{
+    struct stat st;
+    int fd, ret;
+
+    if (flags & (O_CREAT|O_TMPFILE))
+        mode &= ~get_umask(pid);
+
+    /* Opening a FIFO might block the whole supervisor */
+    if (!(flags & O_NONBLOCK) &&
+            syscall(SYS_newfstatat, AT_FDCWD, path, &st, 0) == 0 && S_ISFIFO(st.st_mode)) {
+        pid_t helper = fork();
+        if (helper == 0) {
+            /* Double fork, so nobody has to reap the helper */
+            if (fork() != 0)
+                _exit(0);
+            if ((fd = syscall(SYS_openat, AT_FDCWD, path, flags | O_CLOEXEC, mode)) == -1) {
+                resp->error = -errno;
+                ioctl(listener, SECCOMP_IOCTL_NOTIF_SEND, resp);
+                _exit(0);
+            }
+            if (add_fd(listener, resp, fd, flags) == 0)
+                ioctl(listener, SECCOMP_IOCTL_NOTIF_SEND, resp);
+            _exit(0);
+        }
+        if (helper != -1) {
+            while (waitpid(helper, NULL, 0) == -1 && errno == EINTR);
+            return 1;
+        }
+    }
+
+    if ((fd = syscall(SYS_openat, AT_FDCWD, path, flags | O_CLOEXEC, mode)) == -1) {
+        resp->error = -errno;
+        return 0;
+    }
+    ret = add_fd(listener, resp, fd, flags);
+    if (ret == -1)
+        resp->error = -errno;
+    close(fd);
+    return ret == 1;
+}
+
+
+static void handle_notif (int listener, struct seccomp_notif *req, struct seccomp_notif_resp *resp)
+{
+    const struct supervisor_syscall *sc = NULL;
+    char path[FAKECHROOT_PATH_MAX], resolved[FAKECHROOT_PATH_MAX], mem[64];
+    char path2[FAKECHROOT_PATH_MAX], resolved2[FAKECHROOT_PATH_MAX];
+    int memfd = -1, dirfd, dirfd2, translated, translated2 = 0;
+    long ret = 0, arg1, arg2, arg3;
+    unsigned int i;
+
+    memset(resp, 0, sizeof(*resp));
+    resp->id = req->id;
+    resp->flags = SECCOMP_USER_NOTIF_FLAG_CONTINUE;
+
+    for (i = 0; i < SUPERVISOR_SYSCALLS_COUNT; i++) {
+        if (supervisor_syscalls[i].nr == req->data.nr) {
+            sc = &supervisor_syscalls[i];
+            break;
+        }
+    }
+    if (sc == NULL)
+        goto send;
+
+    snprintf(mem, sizeof(mem), "/proc/%d/mem", (int)req->pid);
+    if ((memfd = syscall(SYS_openat, AT_FDCWD, mem, O_RDWR|O_CLOEXEC)) == -1)
+        goto send;
+    if (read_string(memfd, req->data.args[sc->path_arg], path, sizeof(path)) == -1)
+        goto send;
+    if (sc->path2_arg != ARG_NONE && read_string(memfd, req->data.args[sc->path2_arg], path2, sizeof(path2)) == -1)
+        goto send;
+
+    /* The process might be gone or have reused the memory meanwhile */
+    if (ioctl(listener, SECCOMP_IOCTL_NOTIF_ID_VALID, &req->id) == -1)
+        goto out;
+
+    arg1 = sc->arg1 == ARG_NONE ? 0 : (long)req->data.args[sc->arg1];
+    arg2 = sc->arg2 == ARG_NONE ? 0 : (long)req->data.args[sc->arg2];
+    arg3 = sc->arg3 == ARG_NONE ? 0 : (long)req->data.args[sc->arg3];
+
+    dirfd = sc->dirfd_arg == ARG_NONE ? AT_FDCWD : (int)req->data.args[sc->dirfd_arg];
+    if ((translated = translate_path(req->pid, dirfd, path, resolved)) == -1)
+        goto error;
+
+    if (sc->op == OP_SYMLINK) {
+        /* The target is translated like in symlinkat() of libfakechroot */
+        if (*path2 == '/' && !translate_has_base(fakechroot_base, path2) && !translate_excluded(path2)) {
+            if (translate_expand(fakechroot_base, path2, resolved2, sizeof(resolved2)) == -1) {
+                __set_errno(ENAMETOOLONG);
+                goto error;
+            }
+            translated2 = 1;
+        }
+        else {
+            strlcpy(resolved2, path2, sizeof(resolved2));
+        }
+    }
+    else if (sc->path2_arg != ARG_NONE) {
+        dirfd2 = sc->dirfd2_arg == ARG_NONE ? AT_FDCWD : (int)req->data.args[sc->dirfd2_arg];
+        if ((translated2 = translate_path(req->pid, dirfd2, path2, resolved2)) == -1)
+            goto error;
+        if (!translated2)
+            passthrough_path(req->pid, dirfd2, path2, resolved2);
+    }
+
+    if (!translated && !translated2)
+        goto send;
+
+    /* A relative path without ".." stays in the chroot if its directory does */
+    if (sc->op == OP_DENY && *path != '/' && !has_dotdot(path))
+        goto send;
+
+    /* The kernel reports the empty path better */
+    if ((*path == '\0' && !(sc->op == OP_LINK && (arg1 & AT_EMPTY_PATH))) ||
+            (sc->path2_arg != ARG_NONE && *path2 == '\0'))
+        goto send;
+
+    if (!translated)
+        passthrough_path(req->pid, dirfd, path, resolved);
+
+    if (sc->path2_arg != ARG_NONE)
+        debug("%d: syscall %d \"%s\" \"%s\" -> \"%s\" \"%s\"", (int)req->pid, req->data.nr, path, path2, resolved, resolved2);
+    else
+        debug("%d: syscall %d \"%s\" -> \"%s\"", (int)req->pid, req->data.nr, path, resolved);
+
+    resp->flags = 0;
+
+    switch (sc->op) {
+        case OP_OPEN:
+            if (sc->arg1 == ARG_NONE)
+                arg1 = sc->fixed;
+            if (do_open(listener, resp, req->pid, resolved, (int)arg1, (mode_t)arg2))
+                goto out;
+            goto send;
+
+        case OP_STAT: {
+            struct stat st;
+            int flags = (sc->arg2 == ARG_NONE ? sc->fixed : (int)arg2) & (AT_SYMLINK_NOFOLLOW|AT_NO_AUTOMOUNT);
+            if ((ret = syscall(SYS_newfstatat, AT_FDCWD, resolved, &st, flags)) == 0 &&
+                    pwrite(memfd, &st, sizeof(st), arg1) != sizeof(st))
+                ret = -1;
+            break;
+        }
+
+#ifdef SYS_statx
+        case OP_STATX: {
+            char stx[256];
+            if ((ret = syscall(SYS_statx, AT_FDCWD, resolved, (int)arg1 & ~AT_EMPTY_PATH, (unsigned int)arg2, stx)) == 0 &&
+                    pwrite(memfd, stx, sizeof(stx), arg3) != sizeof(stx))
+                ret = -1;
+            break;
+        }
+#endif
+
+        case OP_ACCESS:
+#ifdef SYS_faccessat2
+            if (arg2 != 0) {
+                ret = syscall(SYS_faccessat2, AT_FDCWD, resolved, (int)arg1, (int)arg2);
+                break;
+            }
+#endif
+            ret = syscall(SYS_faccessat, AT_FDCWD, resolved, (int)arg1);
+            break;
+
+        case OP_READLINK: {
+            char link[FAKECHROOT_PATH_MAX];
+            if ((ret = syscall(SYS_readlinkat, AT_FDCWD, resolved, link, sizeof(link) - 1)) == -1)
+                break;
+            link[ret] = '\0';
+            if (translate_has_base(fakechroot_base, link)) {
+                translate_narrow(fakechroot_base, link);
+                ret = strlen(link);
+            }
+            if (ret > arg2)
+                ret = arg2;
+            if (pwrite(memfd, link, ret, arg1) != ret)
+                ret = -1;
+            break;
+        }
+
+        case OP_MKDIR:
+            ret = syscall(SYS_mkdirat, AT_FDCWD, resolved, (mode_t)arg1 & ~get_umask(req->pid));
+            break;
+
+        case OP_UNLINK:
+            ret = syscall(SYS_unlinkat, AT_FDCWD, resolved, sc->arg1 == ARG_NONE ? (int)sc->fixed : (int)arg1);
+            break;
+
+        case OP_RENAME:
+#ifdef SYS_renameat2
+            ret = syscall(SYS_renameat2, AT_FDCWD, resolved, AT_FDCWD, resolved2, (unsigned int)arg1);
+#else
+            ret = syscall(SYS_renameat, AT_FDCWD, resolved, AT_FDCWD, resolved2);
+#endif
+            break;
+
+        case OP_LINK: {
+            /* The descriptor of the process is reached through /proc */
+            int flags = *path == '\0' ? AT_SYMLINK_FOLLOW : (int)arg1 & AT_SYMLINK_FOLLOW;
+            ret = syscall(SYS_linkat, AT_FDCWD, resolved, AT_FDCWD, resolved2, flags);
+            break;
+        }
+
+        case OP_SYMLINK:
+            ret = syscall(SYS_symlinkat, resolved2, AT_FDCWD, resolved);
+            break;
+
+        case OP_CHMOD:
+            ret = syscall(SYS_fchmodat, AT_FDCWD, resolved, (mode_t)arg1);
+            break;
+
+        case OP_CHOWN: {
+            int flags = (sc->arg3 == ARG_NONE ? sc->fixed : (int)arg3) & AT_SYMLINK_NOFOLLOW;
+            ret = syscall(SYS_fchownat, AT_FDCWD, resolved, (uid_t)arg1, (gid_t)arg2, flags);
+            break;
+        }
+
+        case OP_TRUNCATE:
+            ret = syscall(SYS_truncate, resolved, (off_t)arg1);
+            break;
+
+        case OP_UTIMENS: {
+            struct timespec ts[2];
+            if (arg1 != 0 && pread(memfd, ts, sizeof(ts), arg1) != sizeof(ts)) {
+                ret = -1;
+                __set_errno(EFAULT);
+                break;
+            }
+            ret = syscall(SYS_utimensat, AT_FDCWD, resolved, arg1 != 0 ? ts : NULL, (int)arg2 & AT_SYMLINK_NOFOLLOW);
+            break;
+        }
+
+        case OP_MKNOD:
+            ret = syscall(SYS_mknodat, AT_FDCWD, resolved, (mode_t)arg1 & ~get_umask(req->pid), (unsigned int)arg2);
+            break;
+
+        case OP_DENY:
+            /* Can't be done by the supervisor and the path can't be changed */
+            fprintf(stderr, "fakechroot-supervisor: %s(\"%s\") of statically linked binary can't be translated\n",
+                    deny_name(req->data.nr), path);
+            ret = -1;
+            __set_errno(EPERM);
+            break;
+
+        default:
+            resp->flags = SECCOMP_USER_NOTIF_FLAG_CONTINUE;
+            goto send;
+    }
+
+    if (ret == -1)
+        resp->error = -errno;
+    else
+        resp->val = ret;
+    goto send;
+
+error:
+    resp->flags = 0;
+    resp->error = -errno;
+
+send:
+    if (ioctl(listener, SECCOMP_IOCTL_NOTIF_SEND, resp) == -1 && errno != ENOENT)
+        debug("SECCOMP_IOCTL_NOTIF_SEND: %s", strerror(errno));
+out:
+    if (memfd != -1)
+        close(memfd);
+}
+
+
+static void serve (int listener)
+{
+    struct seccomp_notif_sizes sizes;
+    struct seccomp_notif *req;
+    struct seccomp_notif_resp *resp;
+    struct pollfd pfd;
+
+    if (syscall(SYS_seccomp, SECCOMP_GET_NOTIF_SIZES, 0, &sizes) == -1)
+        return;
+    req = malloc(sizes.seccomp_notif > sizeof(*req) ? sizes.seccomp_notif : sizeof(*req));
+    resp = malloc(sizes.seccomp_notif_resp > sizeof(*resp) ? sizes.seccomp_notif_resp : sizeof(*resp));
+    if (req == NULL || resp == NULL)
+        return;
+
+    pfd.fd = listener;
+    pfd.events = POLLIN;
+
+    /* POLLHUP comes when the last filtered process is gone */
+    for (;;) {
+        if (poll(&pfd, 1, -1) == -1) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (pfd.revents & POLLIN) {
+            memset(req, 0, sizes.seccomp_notif);
+            if (ioctl(listener, SECCOMP_IOCTL_NOTIF_RECV, req) == -1) {
+                if (errno == EINTR || errno == ENOENT)
+                    continue;
+                break;
+            }
+            handle_notif(listener, req, resp);
+        }
+        else if (pfd.revents & (POLLHUP|POLLERR|POLLNVAL)) {
+            break;
+        }
+    }
+
+    free(req);
+    free(resp);
+}
+
+
+static int install_filter (void)
+{
+#ifdef SUPERVISOR_AUDIT_ARCH
+    struct sock_filter filter[4 + SUPERVISOR_SYSCALLS_COUNT + 2];
+    struct sock_fprog prog;
+    unsigned int i, n = 0;
+
+    filter[n++] = (struct sock_filter) BPF_STMT(BPF_LD|BPF_W|BPF_ABS, offsetof(struct seccomp_data, arch));
+    filter[n++] = (struct sock_filter) BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, SUPERVISOR_AUDIT_ARCH, 1, 0);
+    filter[n++] = (struct sock_filter) BPF_STMT(BPF_RET|BPF_K, SECCOMP_RET_ALLOW);
+    filter[n++] = (struct sock_filter) BPF_STMT(BPF_LD|BPF_W|BPF_ABS, offsetof(struct seccomp_data, nr));
+    for (i = 0; i < SUPERVISOR_SYSCALLS_COUNT; i++) {
+        filter[n++] = (struct sock_filter) BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, supervisor_syscalls[i].nr,
+                                                    SUPERVISOR_SYSCALLS_COUNT - i, 0);
+    }
+    filter[n++] = (struct sock_filter) BPF_STMT(BPF_RET|BPF_K, SECCOMP_RET_ALLOW);
+    filter[n++] = (struct sock_filter) BPF_STMT(BPF_RET|BPF_K, SECCOMP_RET_USER_NOTIF);
+
+    prog.len = n;
+    prog.filter = filter;
+
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == -1)
+        return -1;
+
+    return syscall(SYS_seccomp, SECCOMP_SET_MODE_FILTER, SECCOMP_FILTER_FLAG_NEW_LISTENER, &prog);
+#else
+    __set_errno(ENOSYS);
+    return -1;
+#endif
+}
+
+
+static int send_fd (int sock, int fd)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    char c = 0;
+    union {
+        struct cmsghdr cmsg;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } u;
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &c;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = u.buf;
+    msg.msg_controllen = sizeof(u.buf);
+    u.cmsg.cmsg_level = SOL_SOCKET;
+    u.cmsg.cmsg_type = SCM_RIGHTS;
+    u.cmsg.cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(&u.cmsg), &fd, sizeof(int));
+
+    return sendmsg(sock, &msg, 0) == 1 ? 0 : -1;
+}
+
+
+static int recv_fd (int sock)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char c;
+    int fd;
+    union {
+        struct cmsghdr cmsg;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } u;
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &c;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = u.buf;
+    msg.msg_controllen = sizeof(u.buf);
+
+    if (recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != 1)
+        return -1;
+    if ((cmsg = CMSG_FIRSTHDR(&msg)) == NULL || cmsg->cmsg_type != SCM_RIGHTS)
+        return -1;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
+
+/* Signals sent with kill(2) to the supervisor are meant for the child.
+   Signals generated by the terminal reach the child anyway. */
+static void forward_signal (int sig, siginfo_t *info, void *context)
+{
+    (void)context;
+    if (child_pid > 0 && (info == NULL || info->si_code == SI_USER || info->si_code == SI_QUEUE))
+        kill(child_pid, sig);
+}
+
+
+int main (int argc, char *argv[])
+{
+    static const int signals[] = { SIGHUP, SIGINT, SIGQUIT, SIGTERM, SIGUSR1, SIGUSR2, SIGWINCH, SIGCONT };
+    extern char **environ;
+    struct sigaction sa;
+    int sv[2], listener, status;
+    unsigned int i;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s path argv0 [arg...]\n", argv[0]);
+        exit(2);
+    }
+
+    fakechroot_base = getenv("FAKECHROOT_BASE");
+    if (fakechroot_base == NULL || *fakechroot_base == '\0') {
+        syscall(SYS_execve, argv[1], &argv[2], environ);
+        perror(argv[1]);
+        exit(127);
+    }
+    translate_exclude_init(getenv("FAKECHROOT_EXCLUDE_PATH"));
+
+    if (socketpair(AF_UNIX, SOCK_STREAM|SOCK_CLOEXEC, 0, sv) == -1) {
+        perror("socketpair");
+        exit(127);
+    }
+
+    if ((child_pid = fork()) == -1) {
+        perror("fork");
+        exit(127);
+    }
+
+    if (child_pid == 0) {
+        close(sv[0]);
+        if ((listener = install_filter()) == -1) {
+            debug("seccomp filter is not available: %s", strerror(errno));
+        }
+        else {
+            send_fd(sv[1], listener);
+            close(listener);
+        }
+        close(sv[1]);
+        syscall(SYS_execve, argv[1], &argv[2], environ);
+        perror(argv[1]);
+        _exit(127);
+    }
+
+    close(sv[1]);
+
+    /* The umask of the child is applied by hand */
+    umask(0);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = forward_signal;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    for (i = 0; i < sizeof(signals) / sizeof(signals[0]); i++)
+        sigaction(signals[i], &sa, NULL);
+
+    listener = recv_fd(sv[0]);
+    close(sv[0]);
+
+    if (listener != -1) {
+        serve(listener);
+        close(listener);
+    }
+
+    while (waitpid(child_pid, &status, 0) == -1) {
+        if (errno != EINTR)
+            exit(127);
+    }
+
+    if (WIFSIGNALED(status)) {
+        signal(WTERMSIG(status), SIG_DFL);
+        kill(getpid(), WTERMSIG(status));
+    }
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 127;
+}
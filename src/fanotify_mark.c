@@ -0,0 +1,42 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+#include <config.h>
+
+#if defined(HAVE_FANOTIFY_MARK) && defined(HAVE_SYS_FANOTIFY_H)
+
+#define _ATFILE_SOURCE
+#include <stdint.h>
+#include <sys/fanotify.h>
+#include "libfakechroot.h"
+
+
+wrapper(fanotify_mark, int, (int fanotify_fd, unsigned int flags, uint64_t mask, int dirfd, const char * pathname))
+{
+    char fakechroot_abspath[FAKECHROOT_PATH_MAX];
+    char fakechroot_buf[FAKECHROOT_PATH_MAX];
+    debug("fanotify_mark(%d, %u, %llu, %d, \"%s\")", fanotify_fd, flags, (unsigned long long)mask, dirfd, pathname);
+    /* NULL pathname marks dirfd itself */
+    expand_chroot_path_at(dirfd, pathname);
+    return nextcall(fanotify_mark)(fanotify_fd, flags, mask, dirfd, pathname);
+}
+
+#else
+typedef int empty_translation_unit;
+#endif
@@ -0,0 +1,44 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+/*
+ * fstatat() is not wrapped.  The walkers in fts.c and ftw.c stat entries
+ * relative to an open directory with nextcall(fstatat), so the call
+ * doesn't go through another exported fstatat() which would translate
+ * the name again.
+ */
+
+#include <config.h>
+
+#define _ATFILE_SOURCE
+#define _LARGEFILE64_SOURCE
+#include "fstatat.h"
+
+
+#ifdef HAVE_FSTATAT
+wrapper_decl(fstatat);
+#endif
+
+#ifdef HAVE_FSTATAT64
+wrapper_decl(fstatat64);
+#endif
+
+#if !defined(HAVE_FSTATAT) && !defined(HAVE_FSTATAT64)
+typedef int empty_translation_unit;
+#endif
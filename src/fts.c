@@ -46,11 +46,20 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <fts.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #include "libfakechroot.h"
+#include "openat.h"
+
+#if defined(__linux__) && defined(HAVE_SYS_SYSCALL_H)
+# include <sys/syscall.h>
+# ifdef SYS_getdents64
+#  define FTS_GETDENTS64 1
+# endif
+#endif
 
 /* Largest alignment size needed, minus one.
    Usually long double is the worst case.  */
@@ -68,19 +77,11 @@
 
 #define FTS_MAXLEVEL 0x7fff
 
-#ifndef _D_ALLOC_NAMLEN
-# ifdef HAVE_STRUCT_DIRENT_D_NAMLEN
-#  define _D_EXACT_NAMLEN(d) ((d)->d_namlen)
-#  define _D_ALLOC_NAMLEN(d) (_D_EXACT_NAMLEN (d) + 1)
-# else
-#  define _D_EXACT_NAMLEN(d) (strlen ((d)->d_name))
-#  ifdef HAVE_STRUCT_DIRENT_D_RECLEN
-#   define _D_ALLOC_NAMLEN(d) (((char *) (d) + (d)->d_reclen) - &(d)->d_name[0])
-#  else
-#   define _D_ALLOC_NAMLEN(d) (sizeof (d)->d_name > 1 ? sizeof (d)->d_name : \
-                              _D_EXACT_NAMLEN (d) + 1)
-#  endif
-# endif
+/* The node keeps an open descriptor of the directory in fts_symfd. */
+#define FTS_HASDIRFD 0x80
+
+#ifndef O_CLOEXEC
+# define O_CLOEXEC 0
 #endif
 
 /* Support for the LFS API version.  */
@@ -101,6 +102,39 @@
 # define LSTAT lstat
 #endif
 
+/*
+ * Entries are stat()ed relative to the descriptor of their parent
+ * directory with the real function, so the path is not translated again.
+ */
+#ifndef FTS64_C__
+# if defined(HAVE___FXSTATAT) && defined(_STAT_VER)
+#  include "__fxstatat.h"
+#  define fts_fstatat(dirfd, path, buf, flags) nextcall(__fxstatat)(_STAT_VER, dirfd, path, buf, flags)
+# elif defined(HAVE_FSTATAT)
+#  include "fstatat.h"
+#  define fts_fstatat nextcall(fstatat)
+# endif
+#else
+# if defined(HAVE___FXSTATAT64) && defined(_STAT_VER)
+#  include "__fxstatat64.h"
+#  define fts_fstatat(dirfd, path, buf, flags) nextcall(__fxstatat64)(_STAT_VER, dirfd, path, buf, flags)
+# elif defined(HAVE_FSTATAT64)
+#  include "fstatat.h"
+#  define fts_fstatat nextcall(fstatat64)
+# endif
+#endif
+
+/* Directory stream read from a descriptor which stays open */
+struct fts_dirstream {
+#ifdef FTS_GETDENTS64
+        int fd;
+        char *buf;
+        size_t pos, len;
+#else
+        DIR *dirp;
+#endif
+};
+
 static FTSENTRY   *fts_alloc(FTSOBJ *, char *, size_t);
 static FTSENTRY   *fts_build(FTSOBJ *, int);
 static void      fts_lfree(FTSENTRY *);
@@ -110,7 +144,11 @@ static void      fts_padjust(FTSOBJ *, FTSENTRY *);
 static int       fts_palloc(FTSOBJ *, size_t);
 static FTSENTRY   *fts_sort(FTSOBJ *, FTSENTRY *, int);
 static u_short   fts_stat(FTSOBJ *, FTSENTRY *, int);
-static int       fts_safe_changedir(FTSOBJ *, FTSENTRY *, int, char *);
+static int       fts_opendirfd(FTSENTRY *);
+static void      fts_closedirfd(FTSENTRY *);
+static int       fts_opendirstream(struct fts_dirstream *, int);
+static char     *fts_readdirstream(struct fts_dirstream *, unsigned char *);
+static void      fts_closedirstream(struct fts_dirstream *);
 
 #define ISDOT(a)        (a[0] == '.' && (!a[1] || (a[1] == '.' && !a[2])))
 
@@ -118,8 +156,6 @@ static int       fts_safe_changedir(FTSOBJ *, FTSENTRY *, int, char *);
 #define ISSET(opt)      (sp->fts_options & (opt))
 #define SET(opt)        (sp->fts_options |= (opt))
 
-#define FCHDIR(sp, fd)  (!ISSET(FTS_NOCHDIR) && fchdir(fd))
-
 /* fts_build flags */
 #define BCHILD          1               /* fts_children */
 #define BNAMES          2               /* fts_children, names only */
@@ -149,9 +185,12 @@ FTS_OPEN(char * const *argv, int options,
         sp->fts_compar = (void *)compar;
         sp->fts_options = options;
 
-        /* Logical walks turn on NOCHDIR; symbolic links are too hard. */
-        if (ISSET(FTS_LOGICAL))
-                SET(FTS_NOCHDIR);
+        /*
+         * The working directory is never changed: directories are read and
+         * their entries are stat()ed through descriptors opened relative to
+         * the parent directory, so only the root paths are translated.
+         */
+        SET(FTS_NOCHDIR);
 
         /*
          * Start out with 1K of path space, and enough, in any case,
@@ -214,16 +253,6 @@ FTS_OPEN(char * const *argv, int options,
         sp->fts_cur->fts_link = root;
         sp->fts_cur->fts_info = FTS_INIT;
 
-        /*
-         * If using chdir(2), grab a file descriptor pointing to dot to ensure
-         * that we can get back here; this could be avoided for some paths,
-         * but almost certainly not worth the effort.  Slashes, symbolic links,
-         * and ".." are all fairly nasty problems.  Note, if we can't get the
-         * descriptor we run anyway, just more slowly.
-         */
-        if (!ISSET(FTS_NOCHDIR) && (sp->fts_rfd = open(".", O_RDONLY, 0)) < 0)
-                SET(FTS_NOCHDIR);
-
         if (nitems == 0)
                 free(parent);
 
@@ -264,7 +293,6 @@ int
 FTS_CLOSE(FTSOBJ *sp)
 {
         FTSENTRY *freep, *p;
-        int rfd, error = 0;
 
         debug("fts_close(&sp)");
 
@@ -277,14 +305,12 @@ FTS_CLOSE(FTSOBJ *sp)
                 for (p = sp->fts_cur; p->fts_level >= FTS_ROOTLEVEL;) {
                         freep = p;
                         p = p->fts_link ? p->fts_link : p->fts_parent;
+                        fts_closedirfd(freep);
                         free(freep);
                 }
                 free(p);
         }
 
-        /* Stash the original directory fd if needed. */
-        rfd = ISSET(FTS_NOCHDIR) ? -1 : sp->fts_rfd;
-
         /* Free up child linked list, sort array, path buffer, stream ptr.*/
         if (sp->fts_child)
                 fts_lfree(sp->fts_child);
@@ -293,16 +319,7 @@ FTS_CLOSE(FTSOBJ *sp)
         free(sp->fts_path);
         free(sp);
 
-        /* Return to original directory, checking for error. */
-        if (rfd != -1) {
-                int saved_errno;
-                error = fchdir(rfd);
-                saved_errno = errno;
-                (void)close(rfd);
-                errno = saved_errno;
-        }
-
-        return (error);
+        return (0);
 }
 
 /*
@@ -319,7 +336,6 @@ FTS_READ(FTSOBJ *sp)
         FTSENTRY *p, *tmp;
         int instr;
         char *t;
-        int saved_errno;
 
         debug("fts_read(&sp)");
 
@@ -342,20 +358,11 @@ FTS_READ(FTSOBJ *sp)
 
         /*
          * Following a symlink -- SLNONE test allows application to see
-         * SLNONE and recover.  If indirecting through a symlink, have
-         * keep a pointer to current location.  If unable to get that
-         * pointer, follow fails.
+         * SLNONE and recover.
          */
         if (instr == FTS_FOLLOW &&
             (p->fts_info == FTS_SL || p->fts_info == FTS_SLNONE)) {
                 p->fts_info = fts_stat(sp, p, 1);
-                if (p->fts_info == FTS_D && !ISSET(FTS_NOCHDIR)) {
-                        if ((p->fts_symfd = open(".", O_RDONLY, 0)) < 0) {
-                                p->fts_errno = errno;
-                                p->fts_info = FTS_ERR;
-                        } else
-                                p->fts_flags |= FTS_SYMFOLLOW;
-                }
                 return (p);
         }
 
@@ -364,8 +371,7 @@ FTS_READ(FTSOBJ *sp)
                 /* If skipped or crossed mount point, do post-order visit. */
                 if (instr == FTS_SKIP ||
                     (ISSET(FTS_XDEV) && p->fts_dev != sp->fts_dev)) {
-                        if (p->fts_flags & FTS_SYMFOLLOW)
-                                (void)close(p->fts_symfd);
+                        fts_closedirfd(p);
                         if (sp->fts_child) {
                                 fts_lfree(sp->fts_child);
                                 sp->fts_child = NULL;
@@ -382,26 +388,11 @@ FTS_READ(FTSOBJ *sp)
                 }
 
                 /*
-                 * Cd to the subdirectory.
-                 *
-                 * If have already read and now fail to chdir, whack the list
-                 * to make the names come out right, and set the parent errno
-                 * so the application will eventually get an error condition.
-                 * Set the FTS_DONTCHDIR flag so that when we logically change
-                 * directories back to the parent we don't do a chdir.
-                 *
                  * If haven't read do so.  If the read fails, fts_build sets
                  * FTS_STOP or the fts_info field of the node.
                  */
-                if (sp->fts_child) {
-                        if (fts_safe_changedir(sp, p, -1, p->fts_accpath)) {
-                                p->fts_errno = errno;
-                                p->fts_flags |= FTS_DONTCHDIR;
-                                for (p = sp->fts_child; p; p = p->fts_link)
-                                        p->fts_accpath =
-                                            p->fts_parent->fts_accpath;
-                        }
-                } else if ((sp->fts_child = fts_build(sp, BREAD)) == NULL) {
+                if (sp->fts_child == NULL &&
+                    (sp->fts_child = fts_build(sp, BREAD)) == NULL) {
                         if (ISSET(FTS_STOP))
                                 return (NULL);
                         return (p);
@@ -417,35 +408,21 @@ next:   tmp = p;
                 free(tmp);
 
                 /*
-                 * If reached the top, return to the original directory (or
-                 * the root of the tree), and load the paths for the next root.
+                 * If reached the top, load the paths for the next root.
                  */
                 if (p->fts_level == FTS_ROOTLEVEL) {
-                        if (FCHDIR(sp, sp->fts_rfd)) {
-                                SET(FTS_STOP);
-                                return (NULL);
-                        }
                         fts_load(sp, p);
                         return (sp->fts_cur = p);
                 }
 
                 /*
                  * User may have called fts_set on the node.  If skipped,
-                 * ignore.  If followed, get a file descriptor so we can
-                 * get back if necessary.
+                 * ignore.
                  */
                 if (p->fts_instr == FTS_SKIP)
                         goto next;
                 if (p->fts_instr == FTS_FOLLOW) {
                         p->fts_info = fts_stat(sp, p, 1);
-                        if (p->fts_info == FTS_D && !ISSET(FTS_NOCHDIR)) {
-                                if ((p->fts_symfd =
-                                    open(".", O_RDONLY, 0)) < 0) {
-                                        p->fts_errno = errno;
-                                        p->fts_info = FTS_ERR;
-                                } else
-                                        p->fts_flags |= FTS_SYMFOLLOW;
-                        }
                         p->fts_instr = FTS_NOINSTR;
                 }
 
@@ -472,33 +449,8 @@ name:           t = sp->fts_path + NAPPEND(p->fts_parent);
         /* NUL terminate the pathname. */
         sp->fts_path[p->fts_pathlen] = '\0';
 
-        /*
-         * Return to the parent directory.  If at a root node or came through
-         * a symlink, go back through the file descriptor.  Otherwise, cd up
-         * one directory.
-         */
-        if (p->fts_level == FTS_ROOTLEVEL) {
-                if (FCHDIR(sp, sp->fts_rfd)) {
-                        SET(FTS_STOP);
-                        sp->fts_cur = p;
-                        return (NULL);
-                }
-        } else if (p->fts_flags & FTS_SYMFOLLOW) {
-                if (FCHDIR(sp, p->fts_symfd)) {
-                        saved_errno = errno;
-                        (void)close(p->fts_symfd);
-                        errno = saved_errno;
-                        SET(FTS_STOP);
-                        sp->fts_cur = p;
-                        return (NULL);
-                }
-                (void)close(p->fts_symfd);
-        } else if (!(p->fts_flags & FTS_DONTCHDIR) &&
-            fts_safe_changedir(sp, p->fts_parent, -1, "..")) {
-                SET(FTS_STOP);
-                sp->fts_cur = p;
-                return (NULL);
-        }
+        /* All children are visited so the directory is not needed. */
+        fts_closedirfd(p);
         p->fts_info = p->fts_errno ? FTS_ERR : FTS_DP;
         return (sp->fts_cur = p);
 }
@@ -527,7 +479,6 @@ FTSENTRY *
 FTS_CHILDREN(FTSOBJ *sp, int instr)
 {
         FTSENTRY *p;
-        int fd;
 
         debug("fts_children(&sp, %d)", instr);
 
@@ -571,26 +522,7 @@ FTS_CHILDREN(FTSOBJ *sp, int instr)
         } else
                 instr = BCHILD;
 
-        /*
-         * If using chdir on a relative path and called BEFORE fts_read does
-         * its chdir to the root of a traversal, we can lose -- we need to
-         * chdir into the subdirectory, and we don't know where the current
-         * directory is, so we can't get back so that the upcoming chdir by
-         * fts_read will work.
-         */
-        if (p->fts_level != FTS_ROOTLEVEL || p->fts_accpath[0] == '/' ||
-            ISSET(FTS_NOCHDIR))
-                return (sp->fts_child = fts_build(sp, instr));
-
-        if ((fd = open(".", O_RDONLY, 0)) < 0)
-                return (NULL);
-        sp->fts_child = fts_build(sp, instr);
-        if (fchdir(fd)) {
-                (void)close(fd);
-                return (NULL);
-        }
-        (void)close(fd);
-        return (sp->fts_child);
+        return (sp->fts_child = fts_build(sp, instr));
 }
 
 /*
@@ -610,15 +542,16 @@ FTS_CHILDREN(FTSOBJ *sp, int instr)
 static FTSENTRY *
 fts_build(FTSOBJ *sp, int type)
 {
-        struct dirent *dp;
+        struct fts_dirstream ds;
         FTSENTRY *p, *head;
         FTSENTRY *cur, *tail;
-        DIR *dirp;
         void *oldaddr;
-        size_t len, maxlen;
-        int nitems, cderrno, descend, level, nlinks, nostat = 0, doadjust;
+        char *name;
+        unsigned char dtype;
+        size_t len, maxlen, namelen;
+        int dfd, nitems, level, nlinks, nostat = 0, doadjust;
         int saved_errno;
-        char *cp = NULL;
+        char *cp;
 
         /* Set current node pointer. */
         cur = sp->fts_cur;
@@ -627,14 +560,27 @@ fts_build(FTSOBJ *sp, int type)
          * Open the directory for reading.  If this fails, we're done.
          * If being called from fts_read, set the fts_info field.
          */
-        if ((dirp = opendir(cur->fts_accpath)) == NULL) {
+        if ((dfd = fts_opendirfd(cur)) < 0 ||
+            fts_opendirstream(&ds, dfd)) {
+                saved_errno = errno;
+                if (dfd >= 0)
+                        (void)close(dfd);
                 if (type == BREAD) {
                         cur->fts_info = FTS_DNR;
-                        cur->fts_errno = errno;
+                        cur->fts_errno = saved_errno;
                 }
+                errno = saved_errno;
                 return (NULL);
         }
 
+        /*
+         * Keep the descriptor until the post-order visit: the entries are
+         * stat()ed and the subdirectories are opened relative to it.
+         */
+        fts_closedirfd(cur);
+        cur->fts_symfd = dfd;
+        cur->fts_flags |= FTS_HASDIRFD;
+
         /*
          * Nlinks is the number of possible entries of type directory in the
          * directory if we're cheating on stat calls, 0 if we're not doing
@@ -656,50 +602,17 @@ fts_build(FTSOBJ *sp, int type)
             ISSET(FTS_NOSTAT), ISSET(FTS_PHYSICAL), ISSET(FTS_SEEDOT));
 #endif
         /*
-<        * If we're going to need to stat anything or we want to descend
-         * and stay in the directory, chdir.  If this fails we keep going,
-         * but set a flag so we don't chdir after the post-order visit.
-         * We won't be able to stat anything, but we can still return the
-         * names themselves.  Note, that since fts_read won't be able to
-         * chdir into the directory, it will have to return different path
-         * names than before, i.e. "a/b" instead of "b".  Since the node
-         * has already been visited in pre-order, have to wait until the
-         * post-order visit to return the error.  There is a special case
-         * here, if there was nothing to stat then it's not an error to
-         * not be able to stat.  This is all fairly nasty.  If a program
-         * needed sorted entries or stat information, they had better be
-         * checking FTS_NS on the returned nodes.
-         */
-        cderrno = 0;
-        if (nlinks || type == BREAD) {
-                if (fts_safe_changedir(sp, cur, dirfd(dirp), NULL)) {
-                        if (nlinks && type == BREAD)
-                                cur->fts_errno = errno;
-                        cur->fts_flags |= FTS_DONTCHDIR;
-                        descend = 0;
-                        cderrno = errno;
-                        (void)closedir(dirp);
-                        dirp = NULL;
-                } else
-                        descend = 1;
-        } else
-                descend = 0;
-
-        /*
          * Figure out the max file name length that can be stored in the
          * current path -- the inner loop allocates more path as necessary.
          * We really wouldn't have to do the maxlen calculations here, we
          * could do them in fts_read before returning the path, but it's a
          * lot easier here since the length is part of the dirent structure.
          *
-         * If not changing directories set a pointer so that can just append
-         * each new name into the path.
+         * Set a pointer so that can just append each new name into the path.
          */
         len = NAPPEND(cur);
-        if (ISSET(FTS_NOCHDIR)) {
-                cp = sp->fts_path + len;
-                *cp++ = '/';
-        }
+        cp = sp->fts_path + len;
+        *cp++ = '/';
         len++;
         maxlen = sp->fts_pathlen - len;
 
@@ -713,15 +626,17 @@ fts_build(FTSOBJ *sp, int type)
 
         /* Read the directory, attaching each entry to the `link' pointer. */
         doadjust = 0;
-        for (head = tail = NULL, nitems = 0; dirp && (dp = readdir(dirp));) {
-                if (!ISSET(FTS_SEEDOT) && ISDOT(dp->d_name))
+        for (head = tail = NULL, nitems = 0;
+            (name = fts_readdirstream(&ds, &dtype));) {
+                if (!ISSET(FTS_SEEDOT) && ISDOT(name))
                         continue;
 
-                if (!(p = fts_alloc(sp, dp->d_name, _D_EXACT_NAMLEN (dp))))
+                namelen = strlen(name);
+                if (!(p = fts_alloc(sp, name, namelen)))
                         goto mem1;
-                if (_D_EXACT_NAMLEN (dp) >= maxlen) {   /* include space for NUL */
+                if (namelen >= maxlen) {        /* include space for NUL */
                         oldaddr = sp->fts_path;
-                        if (fts_palloc(sp, _D_EXACT_NAMLEN (dp) +len + 1)) {
+                        if (fts_palloc(sp, namelen + len + 1)) {
                                 /*
                                  * No more memory for path or structures.  Save
                                  * errno, free up the current structure and the
@@ -731,7 +646,8 @@ mem1:                           saved_errno = errno;
                                 if (p)
                                         free(p);
                                 fts_lfree(head);
-                                (void)closedir(dirp);
+                                fts_closedirstream(&ds);
+                                fts_closedirfd(cur);
                                 cur->fts_info = FTS_ERR;
                                 SET(FTS_STOP);
                                 errno = saved_errno;
@@ -740,15 +656,14 @@ mem1:                           saved_errno = errno;
                         /* Did realloc() change the pointer? */
                         if (oldaddr != sp->fts_path) {
                                 doadjust = 1;
-                                if (ISSET(FTS_NOCHDIR))
-                                        cp = sp->fts_path + len;
+                                cp = sp->fts_path + len;
                         }
                         maxlen = sp->fts_pathlen - len;
                 }
 
                 p->fts_level = level;
                 p->fts_parent = sp->fts_cur;
-                p->fts_pathlen = len + _D_EXACT_NAMLEN (dp);
+                p->fts_pathlen = len + namelen;
                 if (p->fts_pathlen < len) {
                         /*
                          * If we wrap, free up the current structure and
@@ -757,36 +672,25 @@ mem1:                           saved_errno = errno;
                          */
                         free(p);
                         fts_lfree(head);
-                        (void)closedir(dirp);
+                        fts_closedirstream(&ds);
+                        fts_closedirfd(cur);
                         cur->fts_info = FTS_ERR;
                         SET(FTS_STOP);
                         errno = ENAMETOOLONG;
                         return (NULL);
                 }
 
-                if (cderrno) {
-                        if (nlinks) {
-                                p->fts_info = FTS_NS;
-                                p->fts_errno = cderrno;
-                        } else
-                                p->fts_info = FTS_NSOK;
-                        p->fts_accpath = cur->fts_accpath;
-                } else if (nlinks == 0
+                p->fts_accpath = p->fts_path;
+                if (nlinks == 0
 #ifdef DT_DIR
                     || (nostat &&
-                    dp->d_type != DT_DIR && dp->d_type != DT_UNKNOWN)
+                    dtype != DT_DIR && dtype != DT_UNKNOWN)
 #endif
                     ) {
-                        p->fts_accpath =
-                            ISSET(FTS_NOCHDIR) ? p->fts_path : p->fts_name;
                         p->fts_info = FTS_NSOK;
                 } else {
                         /* Build a file name for fts_stat to stat. */
-                        if (ISSET(FTS_NOCHDIR)) {
-                                p->fts_accpath = p->fts_path;
-                                memmove(cp, p->fts_name, p->fts_namelen + 1);
-                        } else
-                                p->fts_accpath = p->fts_name;
+                        memmove(cp, p->fts_name, p->fts_namelen + 1);
                         /* Stat it. */
                         p->fts_info = fts_stat(sp, p, 0);
 
@@ -806,8 +710,7 @@ mem1:                           saved_errno = errno;
                 }
                 ++nitems;
         }
-        if (dirp)
-                (void)closedir(dirp);
+        fts_closedirstream(&ds);
 
         /*
          * If realloc() changed the address of the path, adjust the
@@ -816,33 +719,14 @@ mem1:                           saved_errno = errno;
         if (doadjust)
                 fts_padjust(sp, head);
 
-        /*
-         * If not changing directories, reset the path back to original
-         * state.
-         */
-        if (ISSET(FTS_NOCHDIR)) {
-                if (len == sp->fts_pathlen || nitems == 0)
-                        --cp;
-                *cp = '\0';
-        }
-
-        /*
-         * If descended after called from fts_children or after called from
-         * fts_read and nothing found, get back.  At the root level we use
-         * the saved fd; if one of fts_open()'s arguments is a relative path
-         * to an empty directory, we wind up here with no other way back.  If
-         * can't get back, we're done.
-         */
-        if (descend && (type == BCHILD || !nitems) &&
-            (cur->fts_level == FTS_ROOTLEVEL ? FCHDIR(sp, sp->fts_rfd) :
-            fts_safe_changedir(sp, cur->fts_parent, -1, ".."))) {
-                cur->fts_info = FTS_ERR;
-                SET(FTS_STOP);
-                return (NULL);
-        }
+        /* Reset the path back to original state. */
+        if (len == sp->fts_pathlen || nitems == 0)
+                --cp;
+        *cp = '\0';
 
         /* If didn't find anything, return NULL. */
         if (!nitems) {
+                fts_closedirfd(cur);
                 if (type == BREAD)
                         cur->fts_info = FTS_DP;
                 return (NULL);
@@ -862,10 +746,34 @@ fts_stat(FTSOBJ *sp, FTSENTRY *p, int follow)
         INO_T ino;
         struct STAT *sbp, sb;
         int saved_errno;
+#ifdef fts_fstatat
+        int dfd, flags;
+#endif
 
         /* If user needs stat info, stat buffer already allocated. */
         sbp = ISSET(FTS_NOSTAT) ? &sb : p->fts_statp;
 
+#ifdef fts_fstatat
+        /*
+         * Below the root, use the descriptor of the parent directory.  The
+         * same rules apply as for the path based calls below.
+         */
+        if (p->fts_level > FTS_ROOTLEVEL &&
+            (p->fts_parent->fts_flags & FTS_HASDIRFD)) {
+                dfd = p->fts_parent->fts_symfd;
+                flags = ISSET(FTS_LOGICAL) || follow ? 0 : AT_SYMLINK_NOFOLLOW;
+                if (fts_fstatat(dfd, p->fts_name, sbp, flags)) {
+                        saved_errno = errno;
+                        if (!flags && !fts_fstatat(dfd, p->fts_name, sbp,
+                            AT_SYMLINK_NOFOLLOW)) {
+                                errno = 0;
+                                return (FTS_SLNONE);
+                        }
+                        p->fts_errno = saved_errno;
+                        goto err;
+                }
+        } else
+#endif
         /*
          * If doing a logical walk, or application requested FTS_FOLLOW, do
          * a stat(2).  If that fails, check for a non-existent symlink.  If
@@ -1116,39 +1024,142 @@ fts_maxarglen(char * const *argv)
 }
 
 /*
- * Change to dir specified by fd or p->fts_accpath without getting
- * tricked by someone changing the world out from underneath us.
+ * Open the directory of p without getting tricked by someone changing the
+ * world out from underneath us.  Below the root the directory is opened
+ * relative to the descriptor of its parent, so the path is not translated.
  * Assumes p->fts_dev and p->fts_ino are filled in.
  */
 static int
-fts_safe_changedir(FTSOBJ *sp, FTSENTRY *p, int fd, char *path)
+fts_opendirfd(FTSENTRY *p)
 {
-        int ret, oerrno, newfd;
         struct STAT sb;
+        int fd, oerrno;
 
-        newfd = fd;
-        if (ISSET(FTS_NOCHDIR))
-                return (0);
-        if (fd < 0 && (newfd = open(path, O_RDONLY, 0)) < 0)
+#ifdef HAVE_OPENAT
+        if (p->fts_level > FTS_ROOTLEVEL &&
+            (p->fts_parent->fts_flags & FTS_HASDIRFD))
+                fd = nextcall(openat)(p->fts_parent->fts_symfd, p->fts_name,
+                    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        else
+#endif
+                fd = open(p->fts_accpath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
                 return (-1);
-        if (FSTAT(newfd, &sb)) {
-                ret = -1;
+        if (FSTAT(fd, &sb))
                 goto bail;
-        }
         if (p->fts_dev != sb.st_dev || p->fts_ino != sb.st_ino) {
                 errno = ENOENT;         /* disinformation */
-                ret = -1;
                 goto bail;
         }
-        ret = fchdir(newfd);
+        return (fd);
+
 bail:
         oerrno = errno;
-        if (fd < 0)
-                (void)close(newfd);
+        (void)close(fd);
         errno = oerrno;
-        return (ret);
+        return (-1);
+}
+
+static void
+fts_closedirfd(FTSENTRY *p)
+{
+        if (p->fts_flags & FTS_HASDIRFD) {
+                (void)close(p->fts_symfd);
+                p->fts_flags &= ~FTS_HASDIRFD;
+        }
+}
+
+/*
+ * The directory stream doesn't take over the descriptor.  On Linux the
+ * entries are read with getdents64(2) directly, elsewhere with readdir(3)
+ * from a duplicated descriptor.
+ */
+#ifdef FTS_GETDENTS64
+
+#define FTS_DIRBUFSIZ 32768
+
+struct fts_dirent64 {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[];
+};
+
+static int
+fts_opendirstream(struct fts_dirstream *ds, int fd)
+{
+        ds->fd = fd;
+        ds->pos = ds->len = 0;
+        if ((ds->buf = malloc(FTS_DIRBUFSIZ)) == NULL)
+                return (-1);
+        return (0);
+}
+
+static char *
+fts_readdirstream(struct fts_dirstream *ds, unsigned char *type)
+{
+        struct fts_dirent64 *dp;
+        long n;
+
+        if (ds->pos >= ds->len) {
+                if ((n = syscall(SYS_getdents64, ds->fd, ds->buf,
+                    FTS_DIRBUFSIZ)) <= 0)
+                        return (NULL);
+                ds->len = n;
+                ds->pos = 0;
+        }
+        dp = (struct fts_dirent64 *)(ds->buf + ds->pos);
+        ds->pos += dp->d_reclen;
+        *type = dp->d_type;
+        return (dp->d_name);
+}
+
+static void
+fts_closedirstream(struct fts_dirstream *ds)
+{
+        free(ds->buf);
+}
+
+#else
+
+static int
+fts_opendirstream(struct fts_dirstream *ds, int fd)
+{
+        int newfd;
+
+        if ((newfd = dup(fd)) < 0)
+                return (-1);
+        if ((ds->dirp = fdopendir(newfd)) == NULL) {
+                (void)close(newfd);
+                return (-1);
+        }
+        return (0);
 }
 
+static char *
+fts_readdirstream(struct fts_dirstream *ds, unsigned char *type)
+{
+        struct dirent *dp;
+
+        if ((dp = readdir(ds->dirp)) == NULL)
+                return (NULL);
+#ifdef DT_DIR
+        *type = dp->d_type;
+#else
+        *type = 0;
+#endif
+        return (dp->d_name);
+}
+
+static void
+fts_closedirstream(struct fts_dirstream *ds)
+{
+        (void)closedir(ds->dirp);
+}
+
+#endif
+
 #else
 typedef int empty_translation_unit;
 #endif
@@ -67,7 +67,6 @@ char *alloca ();
 #include <fcntl.h>
 #include <ftw.h>
 #include <limits.h>
-#include <search.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -111,6 +110,12 @@ char *alloca ();
 
 #include "libfakechroot.h"
 
+#if ! _LIBC && defined HAVE_PTHREAD_CREATE
+# include <pthread.h>
+# include <signal.h>
+# define FTW_PARALLEL 1
+#endif
+
 #if ! _LIBC && !HAVE_STPCPY && !defined stpcpy
 char *stpcpy (char *, const char *);
 #endif
@@ -150,18 +155,14 @@ char *stpcpy (char *, const char *);
 # define __readdir64 readdir
 # undef __stpcpy
 # define __stpcpy stpcpy
-# undef __tdestroy
-# define __tdestroy tdestroy
-# undef __tfind
-# define __tfind tfind
-# undef __tsearch
-# define __tsearch tsearch
 # undef internal_function
 # define internal_function /* empty */
 # undef dirent64
 # define dirent64 dirent
 # undef MAX
 # define MAX(a, b) ((a) > (b) ? (a) : (b))
+# undef MIN
+# define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
 /* Arrange to make lstat calls go through the wrapper function
@@ -213,11 +214,70 @@ int rpl_lstat (const char *, struct stat *);
 # define PATH_MAX 1024
 #endif
 
+#ifdef FTW_PARALLEL
+/* Directories with fewer entries are not worth waking up the workers.  */
+# define FTW_PARALLEL_MIN 32
+/* Number of threads if FAKECHROOT_PARALLEL_WALK is not a number.  */
+# define FTW_PARALLEL_THREADS 4
+# define FTW_PARALLEL_MAX 64
+
+/* The workers stat names relative to the open directory with the real
+   function.  The wrapper would resolve the descriptor with fchdir() and
+   getcwd(), which is not safe from several threads at once.  */
+# if defined __FTW64_C && defined HAVE___FXSTATAT64 && defined _STAT_VER
+#  include "__fxstatat64.h"
+#  define POOL_FSTATAT(d,f,sb,m) nextcall(__fxstatat64) (_STAT_VER, d, f, sb, m)
+# elif !defined __FTW64_C && defined HAVE___FXSTATAT && defined _STAT_VER
+#  include "__fxstatat.h"
+#  define POOL_FSTATAT(d,f,sb,m) nextcall(__fxstatat) (_STAT_VER, d, f, sb, m)
+# elif defined __FTW64_C && defined HAVE_FSTATAT64
+#  include "fstatat.h"
+#  define POOL_FSTATAT(d,f,sb,m) nextcall(fstatat64) (d, f, sb, m)
+# else
+#  include "fstatat.h"
+#  define POOL_FSTATAT(d,f,sb,m) nextcall(fstatat) (d, f, sb, m)
+# endif
+
+struct stat_result
+{
+  int res;
+  int err;
+  struct STAT st;
+};
+
+/* Pool of threads which stat the entries of one directory at a time.  */
+struct ftw_pool
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  pthread_t *threads;
+  int nthreads;
+  pid_t pid;
+  int stop;
+  unsigned long generation;
+  int busy;
+
+  /* Current batch.  The next entry is taken with an atomic increment.  */
+  int fd;
+  int flags;
+  char **names;
+  struct stat_result *results;
+  size_t count;
+  size_t next;
+};
+#endif
+
 struct dir_data
 {
   DIR *stream;
   int streamfd;
   char *content;
+#ifdef FTW_PARALLEL
+  /* Results of stat calls done in advance for the entries of `content'.  */
+  struct stat_result *results;
+  size_t nresults;
+  size_t nextresult;
+#endif
 };
 
 struct known_object
@@ -226,6 +286,17 @@ struct known_object
   INO_T ino;
 };
 
+/* Open addressing hash set of known objects.  All entries are stored in
+   one table which is freed at the end of the walk.  An empty slot has
+   both members zero, so such an object is remembered separately.  */
+struct known_objects
+{
+  struct known_object *table;
+  size_t size;
+  size_t count;
+  int has_zero;
+};
+
 struct ftw_data
 {
   /* Array with pointers to open directory streams.  */
@@ -257,7 +328,12 @@ struct ftw_data
 
   /* Data structure for keeping fingerprints of already processed
      object.  This is needed when not using FTW_PHYS.  */
-  void *known_objects;
+  struct known_objects known_objects;
+
+#ifdef FTW_PARALLEL
+  /* Set if FAKECHROOT_PARALLEL_WALK is used.  */
+  struct ftw_pool *pool;
+#endif
 };
 
 
@@ -279,41 +355,318 @@ static int ftw_dir (struct ftw_data *data, struct STAT *st,
                     struct dir_data *old_dir) internal_function;
 
 
+static inline size_t
+object_hash (dev_t dev, INO_T ino)
+{
+  unsigned long long h = (unsigned long long) ino * 0x9e3779b97f4a7c15ULL;
+  h ^= (unsigned long long) dev + (h << 6) + (h >> 2);
+  return (size_t) (h ^ (h >> 29));
+}
+
+
+static inline struct known_object *
+object_slot (struct known_object *table, size_t size, dev_t dev, INO_T ino)
+{
+  size_t i = object_hash (dev, ino) & (size - 1);
+
+  /* The table is never full, so there is always an empty slot.  */
+  while ((table[i].dev != 0 || table[i].ino != 0)
+         && (table[i].dev != dev || table[i].ino != ino))
+    i = (i + 1) & (size - 1);
+
+  return &table[i];
+}
+
+
 static int
-object_compare (const void *p1, const void *p2)
+grow_objects (struct known_objects *ko)
 {
-  /* We don't need a sophisticated and useful comparison.  We are only
-     interested in equality.  However, we must be careful not to
-     accidentally compare `holes' in the structure.  */
-  const struct known_object *kp1 = p1, *kp2 = p2;
-  int cmp1;
-  cmp1 = (kp1->ino > kp2->ino) - (kp1->ino < kp2->ino);
-  if (cmp1 != 0)
-    return cmp1;
-  return (kp1->dev > kp2->dev) - (kp1->dev < kp2->dev);
+  size_t newsize = ko->size ? 2 * ko->size : 256;
+  struct known_object *newtable, *p;
+  size_t i;
+
+  newtable = calloc (newsize, sizeof (struct known_object));
+  if (newtable == NULL)
+    return -1;
+
+  for (i = 0; i < ko->size; i++)
+    if (ko->table[i].dev != 0 || ko->table[i].ino != 0)
+      {
+        p = object_slot (newtable, newsize, ko->table[i].dev, ko->table[i].ino);
+        *p = ko->table[i];
+      }
+
+  free (ko->table);
+  ko->table = newtable;
+  ko->size = newsize;
+  return 0;
 }
 
 
 static int
 add_object (struct ftw_data *data, struct STAT *st)
 {
-  struct known_object *newp = malloc (sizeof (struct known_object));
-  if (newp == NULL)
+  struct known_objects *ko = &data->known_objects;
+  struct known_object *p;
+
+  if (st->st_dev == 0 && st->st_ino == 0)
+    {
+      ko->has_zero = 1;
+      return 0;
+    }
+
+  /* Keep the load factor at most 1/2.  */
+  if (2 * (ko->count + 1) > ko->size && grow_objects (ko) != 0)
     return -1;
-  newp->dev = st->st_dev;
-  newp->ino = st->st_ino;
-  return __tsearch (newp, &data->known_objects, object_compare) ? 0 : -1;
+
+  p = object_slot (ko->table, ko->size, st->st_dev, st->st_ino);
+  if (p->dev == 0 && p->ino == 0)
+    {
+      p->dev = st->st_dev;
+      p->ino = st->st_ino;
+      ++ko->count;
+    }
+  return 0;
 }
 
 
 static inline int
 find_object (struct ftw_data *data, struct STAT *st)
 {
-  struct known_object obj;
-  obj.dev = st->st_dev;
-  obj.ino = st->st_ino;
-  return __tfind (&obj, &data->known_objects, object_compare) != NULL;
+  struct known_objects *ko = &data->known_objects;
+  struct known_object *p;
+
+  if (st->st_dev == 0 && st->st_ino == 0)
+    return ko->has_zero;
+  if (ko->size == 0)
+    return 0;
+
+  p = object_slot (ko->table, ko->size, st->st_dev, st->st_ino);
+  return p->dev != 0 || p->ino != 0;
+}
+
+
+#ifdef FTW_PARALLEL
+static void
+stat_batch (struct ftw_pool *pool)
+{
+  struct stat_result *r;
+  size_t i;
+
+  while ((i = __sync_fetch_and_add (&pool->next, 1)) < pool->count)
+    {
+      r = &pool->results[i];
+      r->res = POOL_FSTATAT (pool->fd, pool->names[i], &r->st,
+                             pool->flags);
+      r->err = errno;
+    }
+}
+
+
+static void *
+pool_worker (void *arg)
+{
+  struct ftw_pool *pool = arg;
+  unsigned long generation = 0;
+
+  pthread_mutex_lock (&pool->lock);
+  for (;;)
+    {
+      while (!pool->stop && pool->generation == generation)
+        pthread_cond_wait (&pool->cond, &pool->lock);
+      if (pool->stop)
+        break;
+      generation = pool->generation;
+      pthread_mutex_unlock (&pool->lock);
+
+      stat_batch (pool);
+
+      pthread_mutex_lock (&pool->lock);
+      if (--pool->busy == 0)
+        pthread_cond_broadcast (&pool->cond);
+    }
+  pthread_mutex_unlock (&pool->lock);
+
+  return NULL;
+}
+
+
+static struct ftw_pool *
+pool_create (int nthreads)
+{
+  struct ftw_pool *pool;
+  sigset_t all, old;
+  int i;
+
+  if ((pool = calloc (1, sizeof (struct ftw_pool))) == NULL)
+    return NULL;
+  if ((pool->threads = malloc (nthreads * sizeof (pthread_t))) == NULL)
+    {
+      free (pool);
+      return NULL;
+    }
+  pthread_mutex_init (&pool->lock, NULL);
+  pthread_cond_init (&pool->cond, NULL);
+  pool->pid = getpid ();
+
+  /* Signals of the application are not delivered to the workers.  */
+  sigfillset (&all);
+  pthread_sigmask (SIG_SETMASK, &all, &old);
+  for (i = 0; i < nthreads; i++)
+    if (pthread_create (&pool->threads[i], NULL, pool_worker, pool) != 0)
+      break;
+  pthread_sigmask (SIG_SETMASK, &old, NULL);
+  pool->nthreads = i;
+
+  return pool;
+}
+
+
+static void
+pool_destroy (struct ftw_pool *pool)
+{
+  int i;
+
+  /* There are no workers in a child process if the callback forked.  */
+  if (getpid () == pool->pid)
+    {
+      pthread_mutex_lock (&pool->lock);
+      pool->stop = 1;
+      pthread_cond_broadcast (&pool->cond);
+      pthread_mutex_unlock (&pool->lock);
+
+      for (i = 0; i < pool->nthreads; i++)
+        pthread_join (pool->threads[i], NULL);
+
+      pthread_cond_destroy (&pool->cond);
+      pthread_mutex_destroy (&pool->lock);
+    }
+
+  free (pool->threads);
+  free (pool);
+}
+
+
+/* Stat all names relative to FD.  The calling thread takes part too.  */
+static void
+pool_run (struct ftw_pool *pool, int fd, int flags, char **names,
+          struct stat_result *results, size_t count)
+{
+  int parallel = pool->nthreads > 0 && count >= FTW_PARALLEL_MIN
+                 && getpid () == pool->pid;
+
+  if (parallel)
+    pthread_mutex_lock (&pool->lock);
+
+  pool->fd = fd;
+  pool->flags = flags;
+  pool->names = names;
+  pool->results = results;
+  pool->count = count;
+  pool->next = 0;
+
+  if (parallel)
+    {
+      pool->busy = pool->nthreads;
+      ++pool->generation;
+      pthread_cond_broadcast (&pool->cond);
+      pthread_mutex_unlock (&pool->lock);
+    }
+
+  stat_batch (pool);
+
+  if (parallel)
+    {
+      pthread_mutex_lock (&pool->lock);
+      while (pool->busy > 0)
+        pthread_cond_wait (&pool->cond, &pool->lock);
+      pthread_mutex_unlock (&pool->lock);
+    }
+}
+
+
+/* Read all entries of the directory and stat them with the pool.  The
+   stream is closed then, so the subdirectories don't need to share the
+   descriptor budget with it.  The callbacks are still called in the
+   order of entries by the caller.  */
+static int
+prefetch_dir (struct ftw_data *data, struct dir_data *dirp)
+{
+  size_t bufsize = 1024;
+  size_t actsize = 0;
+  size_t count = 0;
+  size_t i;
+  char *buf, *runp;
+  char **names;
+  struct stat_result *results;
+  struct dirent64 *d;
+  int save_err;
+
+  if ((buf = malloc (bufsize)) == NULL)
+    return -1;
+
+  while ((d = __readdir64 (dirp->stream)) != NULL)
+    {
+      size_t this_len = NAMLEN (d);
+
+      if (d->d_name[0] == '.' && (d->d_name[1] == '\0'
+                                  || (d->d_name[1] == '.' && d->d_name[2] == '\0')))
+        continue;
+
+      if (actsize + this_len + 2 >= bufsize)
+        {
+          char *newp;
+          bufsize += MAX (1024, 2 * this_len);
+          newp = (char *) realloc (buf, bufsize);
+          if (newp == NULL)
+            goto fail;
+          buf = newp;
+        }
+
+      *((char *) __mempcpy (buf + actsize, d->d_name, this_len)) = '\0';
+      actsize += this_len + 1;
+      ++count;
+    }
+
+  /* Terminate the list with an additional NUL byte.  */
+  buf[actsize++] = '\0';
+
+  if ((names = malloc ((count + 1) * sizeof (char *))) == NULL)
+    goto fail;
+  if ((results = malloc ((count + 1) * sizeof (struct stat_result))) == NULL)
+    {
+      free (names);
+      goto fail;
+    }
+
+  for (runp = buf, i = 0; i < count; runp = strchr (runp, '\0') + 1)
+    names[i++] = runp;
+
+  pool_run (data->pool, dirp->streamfd, AT_SYMLINK_NOFOLLOW, names, results,
+            count);
+  free (names);
+
+  __closedir (dirp->stream);
+  dirp->stream = NULL;
+  dirp->streamfd = -1;
+  if (data->actdir-- == 0)
+    data->actdir = data->maxdir - 1;
+  data->dirstreams[data->actdir] = NULL;
+
+  dirp->content = buf;
+  dirp->results = results;
+  dirp->nresults = count;
+  dirp->nextresult = 0;
+
+  return 0;
+
+fail:
+  save_err = errno;
+  free (buf);
+  __set_errno (save_err);
+  return -1;
 }
+#endif
 
 
 static inline int
@@ -419,6 +772,9 @@ open_dir_stream (int *dfdp, struct ftw_data *data, struct dir_data *dirp)
         {
           dirp->streamfd = dirfd (dirp->stream);
           dirp->content = NULL;
+#ifdef FTW_PARALLEL
+          dirp->results = NULL;
+#endif
           data->dirstreams[data->actdir] = dirp;
 
           if (++data->actdir == data->maxdir)
@@ -461,6 +817,16 @@ process_entry (struct ftw_data *data, struct dir_data *dir, const char *name,
   *((char *) __mempcpy (data->dirbuf + data->ftw.base, name, namlen)) = '\0';
 
   int statres;
+#ifdef FTW_PARALLEL
+  if (dir->results != NULL && dir->nextresult < dir->nresults)
+    {
+      struct stat_result *r = &dir->results[dir->nextresult++];
+      st = r->st;
+      statres = r->res;
+      __set_errno (r->err);
+    }
+  else
+#endif
   if (dir->streamfd != -1)
     statres = FXSTATAT (_STAT_VER, dir->streamfd, name, &st,
                         (data->flags & FTW_PHYS) ? AT_SYMLINK_NOFOLLOW : 0);
@@ -592,6 +958,15 @@ fail:
     *startp++ = '/';
   data->ftw.base = startp - data->dirbuf;
 
+#ifdef FTW_PARALLEL
+  if (data->pool != NULL && dir.stream != NULL
+      && prefetch_dir (data, &dir) != 0)
+    {
+      result = -1;
+      goto fail;
+    }
+#endif
+
   while (dir.stream != NULL && (d = __readdir64 (dir.stream)) != NULL)
     {
       result = process_entry (data, &dir, d->d_name, NAMLEN (d), d->d_type);
@@ -631,6 +1006,9 @@ fail:
 
       save_err = errno;
       free (dir.content);
+#ifdef FTW_PARALLEL
+      free (dir.results);
+#endif
       __set_errno (save_err);
     }
 
@@ -735,7 +1113,27 @@ ftw_startup (const char *dir, int is_nftw, void *func, int descriptors,
   data.cvt_arr = is_nftw ? nftw_arr : ftw_arr;
 
   /* No object known so far.  */
-  data.known_objects = NULL;
+  memset (&data.known_objects, '\0', sizeof (data.known_objects));
+
+#ifdef FTW_PARALLEL
+  /* Physical walks can stat the entries in parallel.  */
+  data.pool = NULL;
+  if ((flags & FTW_PHYS) && !(flags & FTW_CHDIR))
+    {
+      const char *parallel = getenv ("FAKECHROOT_PARALLEL_WALK");
+      char *endp;
+      long nthreads;
+
+      if (parallel != NULL && *parallel != '\0')
+        {
+          nthreads = strtol (parallel, &endp, 10);
+          if (endp == parallel)
+            nthreads = FTW_PARALLEL_THREADS;
+          if (nthreads > 1)
+            data.pool = pool_create (MIN (nthreads, FTW_PARALLEL_MAX) - 1);
+        }
+    }
+#endif
 
   /* Now go to the directory containing the initial file/directory.  */
   if (flags & FTW_CHDIR)
@@ -854,7 +1252,11 @@ ftw_startup (const char *dir, int is_nftw, void *func, int descriptors,
   /* Free all memory.  */
  out_fail:
   save_err = errno;
-  __tdestroy (data.known_objects, free);
+#ifdef FTW_PARALLEL
+  if (data.pool != NULL)
+    pool_destroy (data.pool);
+#endif
+  free (data.known_objects.table);
   free (data.dirbuf);
   __set_errno (save_err);
 
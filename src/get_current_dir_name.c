@@ -23,28 +23,20 @@
 #ifdef HAVE_GET_CURRENT_DIR_NAME
 
 #include "libfakechroot.h"
+#include "getcwd_real.h"
 
 
 wrapper(get_current_dir_name, char *, (void))
 {
-    char *cwd, *oldptr, *newptr;
+    char *cwd;
 
     debug("get_current_dir_name()");
-    if ((cwd = nextcall(get_current_dir_name)()) == NULL) {
+    /* $PWD is a fake path, so it can't be checked against "." like libc does */
+    if ((cwd = getcwd_real(NULL, 0)) == NULL) {
         return NULL;
     }
-    oldptr = cwd;
     narrow_chroot_path(cwd);
-    if (cwd == NULL) {
-        return NULL;
-    }
-    if ((newptr = malloc(strlen(cwd)+1)) == NULL) {
-        free(oldptr);
-        return NULL;
-    }
-    strcpy(newptr, cwd);
-    free(oldptr);
-    return newptr;
+    return cwd;
 }
 
 #else
@@ -31,7 +31,7 @@
 #include <sys/un.h>
 
 #include "libfakechroot.h"
-#include "strlcpy.h"
+#include "af_unix.h"
 
 #ifdef HAVE_GETPEERNAME_TYPE_ARG2___SOCKADDR_ARG__
 # define SOCKADDR(addr) ((addr).__sockaddr__)
@@ -51,21 +51,7 @@ wrapper(getpeername, int, (int s, GETPEERNAME_TYPE_ARG2(addr), socklen_t * addrl
 
     status = nextcall(getpeername)(s, addr, addrlen);
     if (status == 0 && SOCKADDR(addr)->sa_family == AF_UNIX) {
-        struct sockaddr_un *addr_un = SOCKADDR_UN(addr);
-        size_t path_max = origlen - offsetof(struct sockaddr_un, sun_path);
-        if (path_max > origlen) {
-            /* underflow, addr does not have space for the path */
-            return status;
-        } else if (path_max > sizeof(addr_un->sun_path)) {
-            path_max = sizeof(addr_un->sun_path);
-        }
-        if (addr_un->sun_path && *(addr_un->sun_path)) {
-            char tmp[FAKECHROOT_PATH_MAX];
-            strlcpy(tmp, addr_un->sun_path, FAKECHROOT_PATH_MAX);
-            narrow_chroot_path(tmp);
-            strlcpy(addr_un->sun_path, tmp, path_max);
-            *addrlen = SUN_LEN(addr_un);
-        }
+        af_unix_narrow(s, SOCKADDR_UN(addr), origlen, addrlen);
     }
 
     return status;
@@ -30,29 +30,36 @@
 wrapper(glob64, int, (const char * pattern, int flags, int (* errfunc) (const char *, int), glob64_t * pglob))
 {
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
-    int rc, i;
+    const char *fakechroot_base;
+    size_t base_len, i, first, offs;
+    int rc;
 
     debug("glob64(\"%s\", %d, &errfunc, &pglob)", pattern, flags);
     expand_chroot_rel_path(pattern);
 
+    /* Entries already appended were narrowed by the previous call */
+    first = (flags & GLOB_APPEND) ? pglob->gl_pathc : 0;
+
     rc = nextcall(glob64)(pattern, flags, errfunc, pglob);
     if (rc < 0)
         return rc;
 
-    for (i = 0; i < pglob->gl_pathc; i++) {
-        const char *fakechroot_base = getenv("FAKECHROOT_BASE");
-        char tmp[FAKECHROOT_PATH_MAX], *tmpptr;
+    if ((fakechroot_base = getenv("FAKECHROOT_BASE")) == NULL)
+        return rc;
+    base_len = strlen(fakechroot_base);
+    offs = (flags & GLOB_DOOFFS) ? pglob->gl_offs : 0;
+
+    for (i = first; i < pglob->gl_pathc; i++) {
+        char *path = pglob->gl_pathv[offs + i];
 
-        strcpy(tmp, pglob->gl_pathv[i]);
+        if (path == NULL || strncmp(path, fakechroot_base, base_len) != 0)
+            continue;
 
-        if (fakechroot_base != NULL) {
-            const char *ptr = strstr(tmp, fakechroot_base);
-            if (ptr != tmp) {
-                tmpptr = tmp;
-            } else {
-                tmpptr = tmp + strlen(fakechroot_base);
-            }
-            strcpy(pglob->gl_pathv[i], tmpptr);
+        if (path[base_len] == '\0') {
+            path[0] = '/';
+            path[1] = '\0';
+        } else if (path[base_len] == '/') {
+            memmove(path, path + base_len, strlen(path + base_len) + 1);
         }
     }
     return rc;
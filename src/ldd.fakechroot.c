@@ -0,0 +1,842 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+/*
+ * Replacement for ldd which doesn't run the dynamic linker.
+ *
+ * Usage: ldd.fakechroot [option...] file...
+ *
+ * It runs outside fake chroot as a FAKECHROOT_CMD_SUBST substitute, so the
+ * absolute file names are relative to FAKECHROOT_BASE_ORIG.  DT_NEEDED
+ * libraries are searched in LD_LIBRARY_PATH, the directories of
+ * /etc/ld.so.conf and the default directories, then in DT_RPATH or
+ * DT_RUNPATH of the object which needs them.  The output is the same as
+ * ldd(1) prints with zero addresses.
+ *
+ * The dynamic sections are read directly from the files.  If
+ * FAKECHROOT_LDD_CACHE is set, they are kept in this file outside fake
+ * chroot and validated with the modification time and the size of the
+ * file.  Nothing is written to fake chroot.
+ */
+
+
+#include <config.h>
+
+#define _GNU_SOURCE
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <ctype.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libfakechroot.h"
+
+
+#define LDD_CACHE_HEADER "# ldd.fakechroot cache 1"
+#define LDD_CACHE_BUCKETS 1024
+#define LDD_CACHE_FIELDS 11
+
+/* The parsed ELF file */
+struct elf_info {
+    struct elf_info * next;
+    char * path;
+    time_t mtime;
+    long mtime_nsec;
+    off_t size;
+    int checked;
+    int elf;
+    int class;
+    int data;
+    int machine;
+    int dynamic;
+    char * rpath;
+    char * runpath;
+    int nneeded;
+    char ** needed;
+};
+
+struct strlist {
+    char ** v;
+    int n;
+    int size;
+};
+
+
+static const char * base = "";
+static char cwd[FAKECHROOT_PATH_MAX];
+static const char * ldsodir = "/lib";
+static struct strlist ld_library_path;
+static int status = 0;
+
+/* The state for one file argument */
+static struct strlist libs;
+static struct strlist libs_name;
+static struct strlist libs_path;
+static int dynamic;
+static int format_set;
+static int format_class;
+static int format_data;
+static int format_machine;
+
+static struct elf_info * cache[LDD_CACHE_BUCKETS];
+static int cache_dirty = 0;
+
+
+static void * xmalloc(size_t size)
+{
+    void * p;
+
+    if ((p = malloc(size)) == NULL) {
+        fprintf(stderr, "fakeldd: out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+
+static char * xstrdup(const char * s)
+{
+    size_t len = strlen(s) + 1;
+
+    return memcpy(xmalloc(len), s, len);
+}
+
+
+static void strlist_insert(struct strlist * list, int pos, const char * s)
+{
+    if (list->n == list->size) {
+        list->size = list->size ? list->size * 2 : 16;
+        if ((list->v = realloc(list->v, list->size * sizeof(char *))) == NULL) {
+            fprintf(stderr, "fakeldd: out of memory\n");
+            exit(1);
+        }
+    }
+    memmove(list->v + pos + 1, list->v + pos, (list->n - pos) * sizeof(char *));
+    list->v[pos] = xstrdup(s);
+    list->n++;
+}
+
+
+#define strlist_push(list, s) strlist_insert((list), (list)->n, (s))
+
+
+static void strlist_clear(struct strlist * list)
+{
+    int i;
+
+    for (i = 0; i < list->n; i++) {
+        free(list->v[i]);
+    }
+    list->n = 0;
+}
+
+
+static int is_regular(const char * path)
+{
+    struct stat st;
+
+    return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+
+static unsigned int cache_hash(const char * s)
+{
+    unsigned int h = 5381;
+
+    while (*s)
+        h = h * 33 + (unsigned char)*s++;
+
+    return h % LDD_CACHE_BUCKETS;
+}
+
+
+static uint64_t elf_get(const unsigned char * p, size_t size, int data)
+{
+    uint64_t v = 0;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        v |= (uint64_t)p[data == ELFDATA2MSB ? size - 1 - i : i] << (8 * i);
+    }
+    return v;
+}
+
+#define ELF_FIELD(p, type, field) \
+    elf_get((p) + offsetof(type, field), sizeof(((type *)0)->field), data)
+#define ELF_GET(p, type, field) \
+    (class == ELFCLASS64 ? ELF_FIELD(p, Elf64_##type, field) : ELF_FIELD(p, Elf32_##type, field))
+
+
+/* Returns the file offset of the virtual address or -1 */
+static int64_t elf_offset(const unsigned char * m, size_t size, int class, int data, uint64_t phoff, uint64_t phentsize, uint64_t phnum, uint64_t vaddr)
+{
+    const unsigned char * ph;
+    uint64_t i, p_vaddr, p_filesz, p_offset;
+
+    if (phentsize == 0 || phoff > size || phnum > (size - phoff) / phentsize) {
+        return -1;
+    }
+
+    for (i = 0; i < phnum; i++) {
+        ph = m + phoff + i * phentsize;
+        if (ELF_GET(ph, Phdr, p_type) != PT_LOAD) continue;
+        p_vaddr = ELF_GET(ph, Phdr, p_vaddr);
+        p_filesz = ELF_GET(ph, Phdr, p_filesz);
+        if (vaddr >= p_vaddr && vaddr - p_vaddr < p_filesz) {
+            p_offset = ELF_GET(ph, Phdr, p_offset);
+            if (p_offset >= size || vaddr - p_vaddr >= size - p_offset) {
+                return -1;
+            }
+            return p_offset + (vaddr - p_vaddr);
+        }
+    }
+    return -1;
+}
+
+
+/* Returns the string from the string table or NULL if it is out of the file */
+static const char * elf_string(const unsigned char * m, size_t size, int64_t strtab, uint64_t strsz, uint64_t offset)
+{
+    if (strtab < 0 || offset >= strsz || (uint64_t)strtab + offset >= size) {
+        return NULL;
+    }
+    if (memchr(m + strtab + offset, '\0', size - strtab - offset) == NULL) {
+        return NULL;
+    }
+    return (const char *)m + strtab + offset;
+}
+
+
+static void elf_parse(const char * path, struct elf_info * info)
+{
+    const unsigned char * m, * ph, * d;
+    uint64_t phoff, phentsize, phnum, dynoff = 0, dynsz = 0, dynentsize, i;
+    uint64_t strtab_vaddr = 0, strsz = 0, rpath = 0, runpath = 0, tag, val;
+    uint64_t * needed = NULL;
+    int64_t strtab;
+    int class, data, fd, has_rpath = 0, has_runpath = 0, n = 0;
+    const char * s;
+    struct stat st;
+    size_t size;
+
+    if ((fd = open(path, O_RDONLY)) == -1) {
+        return;
+    }
+    if (fstat(fd, &st) == -1 || (size = st.st_size) < EI_NIDENT ||
+        (m = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    close(fd);
+
+    class = m[EI_CLASS];
+    data = m[EI_DATA];
+    if (memcmp(m, ELFMAG, SELFMAG) != 0 || (class != ELFCLASS32 && class != ELFCLASS64) ||
+        (data != ELFDATA2LSB && data != ELFDATA2MSB) ||
+        size < (class == ELFCLASS64 ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr))) {
+        goto end;
+    }
+
+    info->elf = 1;
+    info->class = class;
+    info->data = data;
+    info->machine = ELF_GET(m, Ehdr, e_machine);
+
+    phoff = ELF_GET(m, Ehdr, e_phoff);
+    phentsize = ELF_GET(m, Ehdr, e_phentsize);
+    phnum = ELF_GET(m, Ehdr, e_phnum);
+    if (phentsize < (class == ELFCLASS64 ? sizeof(Elf64_Phdr) : sizeof(Elf32_Phdr)) ||
+        phoff > size || phnum > (size - phoff) / phentsize) {
+        goto end;
+    }
+
+    for (i = 0; i < phnum; i++) {
+        ph = m + phoff + i * phentsize;
+        if (ELF_GET(ph, Phdr, p_type) == PT_DYNAMIC) {
+            dynoff = ELF_GET(ph, Phdr, p_offset);
+            dynsz = ELF_GET(ph, Phdr, p_filesz);
+            info->dynamic = 1;
+            break;
+        }
+    }
+    if (!info->dynamic || dynoff > size || dynsz > size - dynoff) {
+        goto end;
+    }
+
+    dynentsize = class == ELFCLASS64 ? sizeof(Elf64_Dyn) : sizeof(Elf32_Dyn);
+    needed = xmalloc((dynsz / dynentsize + 1) * sizeof(uint64_t));
+    for (d = m + dynoff; d + dynentsize <= m + dynoff + dynsz; d += dynentsize) {
+        tag = ELF_GET(d, Dyn, d_tag);
+        val = ELF_GET(d, Dyn, d_un.d_val);
+        if (tag == DT_NULL) break;
+        switch (tag) {
+            case DT_NEEDED: needed[n++] = val; break;
+            case DT_STRTAB: strtab_vaddr = val; break;
+            case DT_STRSZ: strsz = val; break;
+            case DT_RPATH: rpath = val; has_rpath = 1; break;
+            case DT_RUNPATH: runpath = val; has_runpath = 1; break;
+        }
+    }
+
+    strtab = elf_offset(m, size, class, data, phoff, phentsize, phnum, strtab_vaddr);
+
+    info->needed = xmalloc((n + 1) * sizeof(char *));
+    for (i = 0; i < (uint64_t)n; i++) {
+        if ((s = elf_string(m, size, strtab, strsz, needed[i])) != NULL) {
+            info->needed[info->nneeded++] = xstrdup(s);
+        }
+    }
+    if (has_rpath && (s = elf_string(m, size, strtab, strsz, rpath)) != NULL && *s) {
+        info->rpath = xstrdup(s);
+    }
+    if (has_runpath && (s = elf_string(m, size, strtab, strsz, runpath)) != NULL && *s) {
+        info->runpath = xstrdup(s);
+    }
+
+end:
+    free(needed);
+    munmap((void *)m, size);
+}
+
+
+static void elf_info_clear(struct elf_info * info)
+{
+    int i;
+
+    for (i = 0; i < info->nneeded; i++) {
+        free(info->needed[i]);
+    }
+    free(info->needed);
+    free(info->rpath);
+    free(info->runpath);
+    info->needed = NULL;
+    info->rpath = info->runpath = NULL;
+    info->nneeded = info->elf = info->class = info->data = info->machine = info->dynamic = 0;
+}
+
+
+static struct elf_info * cache_find(const char * path, int create)
+{
+    unsigned int h = cache_hash(path);
+    struct elf_info * e;
+
+    for (e = cache[h]; e != NULL; e = e->next) {
+        if (strcmp(e->path, path) == 0) return e;
+    }
+    if (!create) {
+        return NULL;
+    }
+
+    e = xmalloc(sizeof(*e));
+    memset(e, 0, sizeof(*e));
+    e->path = xstrdup(path);
+    e->next = cache[h];
+    cache[h] = e;
+    return e;
+}
+
+
+/* Returns the parsed file or NULL if it is not a regular file.  The entry
+   is checked once per run, so it doesn't change while it is used. */
+static struct elf_info * elf_info_get(const char * path)
+{
+    struct elf_info * e;
+    struct stat st;
+    long nsec;
+
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return NULL;
+    }
+
+#ifdef HAVE_STRUCT_STAT_ST_CTIM_TV_NSEC
+    nsec = st.st_mtim.tv_nsec;
+#else
+    nsec = 0;
+#endif
+
+    e = cache_find(path, 1);
+    if (e->checked) {
+        return e;
+    }
+    e->checked = 1;
+    if (e->mtime == st.st_mtime && e->mtime_nsec == nsec && e->size == st.st_size) {
+        return e;
+    }
+
+    elf_info_clear(e);
+    e->mtime = st.st_mtime;
+    e->mtime_nsec = nsec;
+    e->size = st.st_size;
+    elf_parse(path, e);
+    cache_dirty = 1;
+    return e;
+}
+
+
+static void cache_load(const char * file)
+{
+    struct elf_info * e;
+    char * line = NULL, * p, * fields[LDD_CACHE_FIELDS];
+    size_t linesize = 0;
+    ssize_t len;
+    int i;
+    FILE * fp;
+
+    if ((fp = fopen(file, "r")) == NULL) {
+        return;
+    }
+
+    if (getline(&line, &linesize, fp) == -1 || strcmp(line, LDD_CACHE_HEADER "\n") != 0) {
+        goto end;
+    }
+
+    while ((len = getline(&line, &linesize, fp)) != -1) {
+        if (len > 0 && line[len - 1] == '\n') line[--len] = '\0';
+        p = line;
+        for (i = 0; i < LDD_CACHE_FIELDS && p != NULL; i++) {
+            fields[i] = strsep(&p, "\t");
+        }
+        if (i < LDD_CACHE_FIELDS || *fields[0] != '/' || cache_find(fields[0], 0) != NULL) continue;
+
+        e = cache_find(fields[0], 1);
+        e->mtime = strtol(fields[1], NULL, 10);
+        e->mtime_nsec = strtol(fields[2], NULL, 10);
+        e->size = strtoll(fields[3], NULL, 10);
+        e->elf = atoi(fields[4]);
+        e->class = atoi(fields[5]);
+        e->data = atoi(fields[6]);
+        e->machine = atoi(fields[7]);
+        e->dynamic = atoi(fields[8]);
+        e->rpath = *fields[9] ? xstrdup(fields[9]) : NULL;
+        e->runpath = *fields[10] ? xstrdup(fields[10]) : NULL;
+        e->needed = xmalloc((len + 1) * sizeof(char *));
+        while (p != NULL) {
+            e->needed[e->nneeded++] = xstrdup(strsep(&p, "\t"));
+        }
+    }
+
+end:
+    free(line);
+    fclose(fp);
+}
+
+
+/* Tab and newline separate the fields */
+static int cache_printable(const char * s)
+{
+    return s == NULL || strpbrk(s, "\t\n") == NULL;
+}
+
+
+static void cache_save(const char * file)
+{
+    struct elf_info * e;
+    char tmp[FAKECHROOT_PATH_MAX];
+    FILE * fp;
+    int fd, i, j;
+
+    if (!cache_dirty || snprintf(tmp, sizeof(tmp), "%s.XXXXXX", file) >= (int)sizeof(tmp)) {
+        return;
+    }
+    if ((fd = mkstemp(tmp)) == -1) {
+        return;
+    }
+    if ((fp = fdopen(fd, "w")) == NULL) {
+        close(fd);
+        unlink(tmp);
+        return;
+    }
+
+    fprintf(fp, "%s\n", LDD_CACHE_HEADER);
+    for (i = 0; i < LDD_CACHE_BUCKETS; i++) {
+        for (e = cache[i]; e != NULL; e = e->next) {
+            if (!cache_printable(e->path) || !cache_printable(e->rpath) || !cache_printable(e->runpath)) continue;
+            for (j = 0; j < e->nneeded && cache_printable(e->needed[j]); j++);
+            if (j < e->nneeded) continue;
+
+            fprintf(fp, "%s\t%ld\t%ld\t%lld\t%d\t%d\t%d\t%d\t%d\t%s\t%s",
+                e->path, (long)e->mtime, e->mtime_nsec, (long long)e->size,
+                e->elf, e->class, e->data, e->machine, e->dynamic,
+                e->rpath ? e->rpath : "", e->runpath ? e->runpath : "");
+            for (j = 0; j < e->nneeded; j++) {
+                fprintf(fp, "\t%s", e->needed[j]);
+            }
+            fputc('\n', fp);
+        }
+    }
+
+    if (fclose(fp) != 0 || rename(tmp, file) != 0) {
+        unlink(tmp);
+    }
+}
+
+
+static void load_ldsoconf(const char * file)
+{
+    struct strlist paths = { NULL, 0, 0 };
+    char * line = NULL, * p, * word;
+    size_t linesize = 0;
+    ssize_t len;
+    glob_t g;
+    size_t k;
+    int i;
+    FILE * fp;
+
+    if ((fp = fopen(file, "r")) == NULL) {
+        return;
+    }
+
+    while ((len = getline(&line, &linesize, fp)) != -1) {
+        if (len > 0 && line[len - 1] == '\n') line[--len] = '\0';
+        if ((p = strchr(line, '#')) != NULL) *p = '\0';
+        for (p = line; isspace((unsigned char)*p); p++);
+        if (*p == '\0') continue;
+
+        if (strncmp(line, "include", 7) == 0 && isspace((unsigned char)line[7])) {
+            for (p = line + 7; (word = strsep(&p, " \t\f\r\v")) != NULL; ) {
+                if (*word == '\0') continue;
+                if (glob(word, GLOB_NOCHECK | GLOB_BRACE | GLOB_TILDE, NULL, &g) == 0) {
+                    for (k = 0; k < g.gl_pathc; k++) {
+                        load_ldsoconf(g.gl_pathv[k]);
+                    }
+                    globfree(&g);
+                }
+            }
+            continue;
+        }
+
+        strlist_push(&paths, line);
+    }
+    free(line);
+    fclose(fp);
+
+    /* the directories of the including file come first */
+    for (i = 0; i < paths.n; i++) {
+        strlist_insert(&ld_library_path, i, paths.v[i]);
+    }
+    strlist_clear(&paths);
+    free(paths.v);
+}
+
+
+static const char * libs_get(const char * lib)
+{
+    int i;
+
+    for (i = 0; i < libs_name.n; i++) {
+        if (strcmp(libs_name.v[i], lib) == 0) return libs_path.v[i];
+    }
+    return NULL;
+}
+
+
+static void libs_set(const char * lib, const char * path)
+{
+    strlist_push(&libs_name, lib);
+    strlist_push(&libs_path, path);
+}
+
+
+static int format_matches(const struct elf_info * info)
+{
+    /* objdump shows no format for other files */
+    if (info == NULL || !info->elf) {
+        return 1;
+    }
+    return format_set && info->class == format_class && info->data == format_data && info->machine == format_machine;
+}
+
+
+/* Replaces $ORIGIN and ${ORIGIN} in the directory of DT_RPATH */
+static void expand_origin(const char * dir, const char * origin, char * buf, size_t size)
+{
+    size_t len = 0, n;
+
+    while (*dir && len + 1 < size) {
+        if (strncmp(dir, "$ORIGIN", 7) == 0 || strncmp(dir, "${ORIGIN}", 9) == 0) {
+            n = strlen(origin);
+            if (len + n >= size) break;
+            memcpy(buf + len, origin, n);
+            len += n;
+            dir += dir[1] == '{' ? 9 : 7;
+        }
+        else {
+            buf[len++] = *dir++;
+        }
+    }
+    buf[len] = '\0';
+}
+
+
+static void objdump(const char * file);
+
+
+/* Finds the library in the directories of the object */
+static int ldso_rpath(const char * lib, const struct elf_info * from, char * path, size_t size)
+{
+    char origin[FAKECHROOT_PATH_MAX], dir[FAKECHROOT_PATH_MAX], * list, * p, * s;
+    const char * rpath = from->runpath ? from->runpath : from->rpath;
+    int found = 0;
+
+    if (rpath == NULL) {
+        return 0;
+    }
+
+    strncpy(origin, from->path, sizeof(origin) - 1);
+    origin[sizeof(origin) - 1] = '\0';
+    if ((p = strrchr(origin, '/')) != NULL) *p = '\0';
+
+    p = list = xstrdup(rpath);
+    while (!found && (s = strsep(&p, ":")) != NULL) {
+        if (*s == '\0') continue;
+        expand_origin(s, origin, dir, sizeof(dir));
+        /* $ORIGIN is already a real path */
+        if ((size_t)snprintf(path, size, "%s%s/%s", strstr(s, "ORIGIN") != NULL ? "" : base, dir, lib) >= size) continue;
+        found = is_regular(path) && format_matches(elf_info_get(path));
+    }
+    free(list);
+    return found;
+}
+
+
+static void ldso(const char * lib, const struct elf_info * from)
+{
+    char candidate[FAKECHROOT_PATH_MAX];
+    const char * path = NULL, * found;
+    size_t base_len = strlen(base);
+    int i;
+
+    if ((found = libs_get(lib)) != NULL && *found) {
+        return;
+    }
+
+    if (*lib == '/') {
+        path = lib;
+    }
+    else {
+        for (i = 0; i < ld_library_path.n; i++) {
+            if ((size_t)snprintf(candidate, sizeof(candidate), "%s/%s", ld_library_path.v[i], lib) >= sizeof(candidate) ||
+                !is_regular(candidate) || !format_matches(elf_info_get(candidate))) continue;
+            path = candidate;
+            break;
+        }
+        if (path == NULL && from != NULL && ldso_rpath(lib, from, candidate, sizeof(candidate))) {
+            path = candidate;
+        }
+    }
+
+    strlist_push(&libs, lib);
+    if (path != NULL && is_regular(path)) {
+        if (base_len > 0 && strncmp(path, base, base_len) == 0 && path[base_len] == '/') {
+            path += base_len;
+        }
+        libs_set(lib, path);
+        objdump(libs_path.v[libs_path.n - 1]);
+    }
+}
+
+
+static void objdump(const char * file)
+{
+    char full[FAKECHROOT_PATH_MAX], needed[FAKECHROOT_PATH_MAX];
+    struct elf_info * info;
+    const char * preload;
+    char * list, * p, * s;
+    int i;
+
+    if ((size_t)snprintf(full, sizeof(full), "%s%s%s", *file == '/' ? base : cwd, *file == '/' ? "" : "/", file) >= sizeof(full) ||
+        (info = elf_info_get(full)) == NULL || !info->elf) {
+        return;
+    }
+
+    if (!format_set) {
+        format_set = 1;
+        format_class = info->class;
+        format_data = info->data;
+        format_machine = info->machine;
+
+#ifdef __linux__
+        if (info->class == ELFCLASS64 && (info->machine == EM_X86_64 || info->machine == EM_SPARCV9)) {
+            ldsodir = "/lib64";
+        }
+        else if (info->class == ELFCLASS32 && info->machine == EM_X86_64) {
+            ldsodir = "/libx32";
+        }
+
+        if (info->class == ELFCLASS64) {
+            strlist_push(&libs, "linux-vdso.so.1");
+            libs_set("linux-vdso.so.1", "");
+        }
+        else {
+            strlist_push(&libs, "linux-gate.so.1");
+            libs_set("linux-gate.so.1", "");
+        }
+#endif
+
+        if ((preload = getenv("LD_PRELOAD")) != NULL && *preload) {
+            p = list = xstrdup(preload);
+            /* trailing empty elements are ignored */
+            for (s = p + strlen(p); s > p && strchr(": \t\n\r\f", s[-1]) != NULL; *--s = '\0');
+            while (*list && (s = strsep(&p, ": \t\n\r\f")) != NULL) {
+                ldso(s, NULL);
+            }
+            free(list);
+        }
+    }
+
+    if (info->dynamic) {
+        dynamic = 1;
+    }
+
+    for (i = 0; i < info->nneeded; i++) {
+        if (strncmp(info->needed[i], "ld.", 3) == 0 || strncmp(info->needed[i], "ld-", 3) == 0) {
+            if ((size_t)snprintf(needed, sizeof(needed), "%s/%s", ldsodir, info->needed[i]) < sizeof(needed)) {
+                ldso(needed, info);
+            }
+        }
+        else {
+            ldso(info->needed[i], info);
+        }
+    }
+}
+
+
+int main(int argc, char * argv[])
+{
+    char cache_file[FAKECHROOT_PATH_MAX], file_in_chroot[FAKECHROOT_PATH_MAX];
+    const char * env, * address, * path;
+    struct strlist seen = { NULL, 0, 0 };
+    char * list, * p, * s;
+    int i, j, k, nfiles;
+
+    if ((env = getenv("FAKECHROOT_BASE_ORIG")) != NULL) {
+        base = env;
+    }
+    if (getcwd(cwd, sizeof(cwd)) == NULL) {
+        *cwd = '\0';
+    }
+
+    /* default directories */
+    strlist_push(&ld_library_path, "/usr/lib");
+    strlist_push(&ld_library_path, "/lib");
+    strlist_push(&ld_library_path, "/usr/lib32");
+    strlist_push(&ld_library_path, "/lib32");
+    strlist_push(&ld_library_path, "/usr/lib64");
+    strlist_push(&ld_library_path, "/lib64");
+
+    load_ldsoconf("/etc/ld.so.conf");
+
+    if ((env = getenv("LD_LIBRARY_PATH")) != NULL && *env) {
+        p = list = xstrdup(env);
+        /* trailing empty elements are ignored */
+        for (s = p + strlen(p); s > p && s[-1] == ':'; *--s = '\0');
+        for (k = 0; *list && (s = strsep(&p, ":")) != NULL; k++) {
+            strlist_insert(&ld_library_path, k, s);
+        }
+        free(list);
+    }
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            i++;
+            break;
+        }
+    }
+
+    if (i == argc) {
+        fprintf(stderr, "fakeldd: missing file arguments\n");
+        exit(1);
+    }
+
+    if ((env = getenv("FAKECHROOT_LDD_CACHE")) != NULL) {
+        snprintf(cache_file, sizeof(cache_file), "%s", env);
+    }
+    else {
+        *cache_file = '\0';
+    }
+    if (*cache_file) {
+        cache_load(cache_file);
+    }
+
+    nfiles = argc - i;
+    for (; i < argc; i++) {
+        strlist_clear(&libs);
+        strlist_clear(&libs_name);
+        strlist_clear(&libs_path);
+        strlist_clear(&seen);
+        dynamic = 0;
+        format_set = 0;
+        ldsodir = "/lib";
+
+        if (nfiles > 1) {
+            printf("%s:\n", argv[i]);
+        }
+
+        snprintf(file_in_chroot, sizeof(file_in_chroot), "%s%s", *argv[i] == '/' ? base : "", argv[i]);
+        if (!is_regular(file_in_chroot)) {
+            fflush(stdout);
+            fprintf(stderr, "fakeldd: %s: No such file or directory\n", argv[i]);
+            status = 1;
+            continue;
+        }
+
+        objdump(argv[i]);
+
+        if (!dynamic) {
+            printf("\tnot a dynamic executable\n");
+            status = 1;
+        }
+        else if (libs_name.n == 0) {
+            printf("\tstatically linked\n");
+        }
+
+        address = format_set && format_class == ELFCLASS64 ? "0x0000000000000000" : "0x00000000";
+
+        for (j = 0; j < libs.n; j++) {
+            for (k = 0; k < seen.n && strcmp(seen.v[k], libs.v[j]) != 0; k++);
+            if (k < seen.n) continue;
+            strlist_push(&seen, libs.v[j]);
+
+            if (*libs.v[j] == '/' || strncmp(libs.v[j], "linux-", 6) == 0) {
+                printf("\t%s (%s)\n", libs.v[j], address);
+            }
+            else if ((path = libs_get(libs.v[j])) != NULL && *path) {
+                printf("\t%s => %s (%s)\n", libs.v[j], path, address);
+            }
+            else {
+                printf("\t%s => not found\n", libs.v[j]);
+            }
+        }
+    }
+
+    if (*cache_file) {
+        cache_save(cache_file);
+    }
+
+    return status;
+}
@@ -33,19 +33,22 @@
 #include <stdio.h>
 #include <pwd.h>
 #include <dlfcn.h>
+#include <sched.h>
+#ifdef HAVE_PTHREAD_ATFORK
+# include <pthread.h>
+#endif
 
 #include "setenv.h"
 #include "libfakechroot.h"
 #include "getcwd_real.h"
-#include "strchrnul.h"
+#include "af_unix.h"
+#include "cmd_subst.h"
+#include "dl_name_cache.h"
+#include "library_index.h"
+#include "path_cache.h"
+#include "symlink_cache.h"
 
-#define EXCLUDE_LIST_SIZE 100
 
-
-/* Useful to exclude a list of directories or files */
-static char *exclude_list[EXCLUDE_LIST_SIZE];
-static int exclude_length[EXCLUDE_LIST_SIZE];
-static int list_max = 0;
 static int first = 0;
 
 
@@ -58,7 +61,10 @@ char *preserve_env_list[] = {
     "FAKECHROOT_ELFLOADER",
     "FAKECHROOT_ELFLOADER_OPT_ARGV0",
     "FAKECHROOT_EXCLUDE_PATH",
+    "FAKECHROOT_LDD_CACHE",
     "FAKECHROOT_LDLIBPATH",
+    "FAKECHROOT_PARALLEL_WALK",
+    "FAKECHROOT_SUPERVISOR",
     "FAKECHROOT_VERSION",
     "FAKEROOTKEY",
     "FAKED_MODE",
@@ -91,6 +97,24 @@ LOCAL int fakechroot_debug (const char *fmt, ...)
 #include "getcwd.h"
 
 
+#ifdef HAVE_PTHREAD_ATFORK
+/* Only the thread which called fork() exists in the child, so the locks
+   held by the other threads are released */
+static void fakechroot_fork_child (void)
+{
+    __env_fork_child();
+#ifdef AF_UNIX
+    af_unix_fork_child();
+#endif
+    cmd_subst_fork_child();
+    dl_name_cache_fork_child();
+    library_index_fork_child();
+    path_cache_fork_child();
+    symlink_cache_fork_child();
+}
+#endif
+
+
 /* Bootstrap the library */
 void fakechroot_init (void) CONSTRUCTOR;
 void fakechroot_init (void)
@@ -118,23 +142,14 @@ void fakechroot_init (void)
         first = 1;
 
         /* We get a list of directories or files */
-        if (exclude_path) {
-            int i;
-            for (i = 0; list_max < EXCLUDE_LIST_SIZE; ) {
-                int j;
-                for (j = i; exclude_path[j] != ':' && exclude_path[j] != '\0'; j++);
-                exclude_list[list_max] = malloc(j - i + 2);
-                memset(exclude_list[list_max], '\0', j - i + 2);
-                strncpy(exclude_list[list_max], &(exclude_path[i]), j - i);
-                exclude_length[list_max] = strlen(exclude_list[list_max]);
-                list_max++;
-                if (exclude_path[j] != ':') break;
-                i = j + 1;
-            }
-        }
+        translate_exclude_init(exclude_path);
 
         __setenv("FAKECHROOT", "true", 1);
         __setenv("FAKECHROOT_VERSION", FAKECHROOT, 1);
+
+#ifdef HAVE_PTHREAD_ATFORK
+        pthread_atfork(NULL, NULL, fakechroot_fork_child);
+#endif
     }
 }
 
@@ -172,19 +187,7 @@ LOCAL int fakechroot_localdir (const char * p_path)
     }
 
     /* We try to find if we need direct access to a file */
-    {
-        const size_t len = strlen(v_path);
-        int i;
-
-        for (i = 0; i < list_max; i++) {
-            if (exclude_length[i] > len ||
-                    v_path[exclude_length[i] - 1] != (exclude_list[i])[exclude_length[i] - 1] ||
-                    strncmp(exclude_list[i], v_path, exclude_length[i]) != 0) continue;
-            if (exclude_length[i] == len || v_path[exclude_length[i]] == '/') return 1;
-        }
-    }
-
-    return 0;
+    return translate_excluded(v_path);
 }
 
 
@@ -192,36 +195,39 @@ LOCAL int fakechroot_localdir (const char * p_path)
  * Parse the FAKECHROOT_CMD_SUBST environment variable (the first
  * parameter) and if there is a match with filename, return the
  * substitution in cmd_subst.  Returns non-zero if there was a match.
+ * The variable is compiled into a table, see cmd_subst.c.
  *
  * FAKECHROOT_CMD_SUBST=cmd=subst:cmd=subst:...
  */
 LOCAL int fakechroot_try_cmd_subst (char * env, const char * filename, char * cmd_subst)
 {
-    int len, len2;
-    char *p;
-
     if (env == NULL || filename == NULL)
         return 0;
 
     /* Remove trailing dot from filename */
     if (filename[0] == '.' && filename[1] == '/')
         filename++;
-    len = strlen(filename);
 
-    do {
-        p = strchrnul(env, ':');
+    return cmd_subst_lookup(env, filename, cmd_subst);
+}
 
-        if (strncmp(env, filename, len) == 0 && env[len] == '=') {
-            len2 = p - &env[len+1];
-            if (len2 >= FAKECHROOT_PATH_MAX)
-                len2 = FAKECHROOT_PATH_MAX - 1;
-            strncpy(cmd_subst, &env[len+1], len2);
-            cmd_subst[len2] = '\0';
-            return 1;
-        }
 
-        env = p;
-    } while (*env++ != '\0');
+/*
+ * Takes a spinlock, but gives up after FAKECHROOT_LOCK_TRIES attempts
+ * and returns 0.  The holder could be the thread interrupted by the
+ * signal handler which calls us or a thread which doesn't exist in the
+ * child after fork().
+ */
+#define FAKECHROOT_LOCK_TRIES 1000
 
+LOCAL int fakechroot_lock (volatile int * lock)
+{
+    int i;
+
+    for (i = 0; i < FAKECHROOT_LOCK_TRIES; i++) {
+        if (!__sync_lock_test_and_set(lock, 1))
+            return 1;
+        sched_yield();
+    }
     return 0;
 }
@@ -28,6 +28,7 @@
 
 #include "rel2abs.h"
 #include "rel2absat.h"
+#include "translate.h"
 
 
 #define debug fakechroot_debug
@@ -82,35 +83,13 @@
 
 
 #define narrow_chroot_path(path) \
-    { \
-        if ((path) != NULL && *((char *)(path)) != '\0') { \
-            const char *fakechroot_base = getenv("FAKECHROOT_BASE"); \
-            if (fakechroot_base != NULL) { \
-                char *fakechroot_ptr = strstr((path), fakechroot_base); \
-                if (fakechroot_ptr == (path)) { \
-                    const size_t fakechroot_base_len = strlen(fakechroot_base); \
-                    const size_t path_len = strlen(path); \
-                    if (path_len == fakechroot_base_len) { \
-                        ((char *)(path))[0] = '/'; \
-                        ((char *)(path))[1] = '\0'; \
-                    } \
-                    else if ( ((char *)(path))[fakechroot_base_len] == '/' ) { \
-                        memmove((void *)(path), (path) + fakechroot_base_len, 1 + path_len - fakechroot_base_len); \
-                    } \
-                } \
-            } \
-        } \
-    }
+    translate_narrow(__getenv("FAKECHROOT_BASE"), (char *)(path))
 
 #define expand_chroot_rel_path(path) \
     { \
-        if (!fakechroot_localdir(path)) { \
-            if ((path) != NULL && *((char *)(path)) == '/') { \
-                const char *fakechroot_base = getenv("FAKECHROOT_BASE"); \
-                if (fakechroot_base != NULL ) { \
-                    snprintf(fakechroot_buf, FAKECHROOT_PATH_MAX, "%s%s", fakechroot_base, (path)); \
-                    (path) = fakechroot_buf; \
-                } \
+        if ((path) != NULL && *((char *)(path)) == '/' && !fakechroot_localdir(path)) { \
+            if (translate_expand(__getenv("FAKECHROOT_BASE"), (path), fakechroot_buf, FAKECHROOT_PATH_MAX) != 0) { \
+                (path) = fakechroot_buf; \
             } \
         } \
     }
@@ -217,6 +196,8 @@ int fakechroot_debug (const char *, ...);
 fakechroot_wrapperfn_t fakechroot_loadfunc (struct fakechroot_wrapper *);
 int fakechroot_localdir (const char *);
 int fakechroot_try_cmd_subst (char *, const char *, char *);
+char * __getenv (const char *);
+int fakechroot_lock (volatile int *);
 
 
 /* We don't want to define _BSD_SOURCE and _DEFAULT_SOURCE and include stdio.h */
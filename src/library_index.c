@@ -0,0 +1,278 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+/*
+ * The index of libraries in the fake chroot environment.  It is made by
+ * ldconfig.fakechroot as /etc/ld.so.fakechroot with one library per line:
+ *
+ *   class machine name path
+ *
+ * dlopen() looks up a name without a slash here when the dynamic linker
+ * didn't find it, like it would use ld.so.cache after LD_LIBRARY_PATH and
+ * RUNPATH, so the directories of ld.so.conf in the fake chroot are
+ * searched too.  It is a fallback, not a shortcut: the normal search is
+ * always done first and the libraries loaded at exec never see the index.
+ * The index is loaded again if the file or FAKECHROOT_BASE has changed.
+ */
+
+#include <config.h>
+
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+#define _DEFAULT_SOURCE
+#ifdef HAVE___XSTAT64
+# define _LARGEFILE64_SOURCE
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libfakechroot.h"
+#include "direct_syscall.h"
+#include "open.h"
+#include "strlcpy.h"
+#include "library_index.h"
+
+#ifdef HAVE___XSTAT64
+# include "__xstat64.h"
+# define STAT_T stat64
+# define STAT(path, sb) nextcall(__xstat64)(_STAT_VER, path, sb)
+#else
+# include "stat.h"
+# define STAT_T stat
+# define STAT(path, sb) nextcall(stat)(path, sb)
+#endif
+
+
+#define LIBRARY_INDEX_FILE "/etc/ld.so.fakechroot"
+
+/* Only the libraries which can be loaded by this process are used */
+#ifdef __LP64__
+# define LIBRARY_INDEX_CLASS ELFCLASS64
+#else
+# define LIBRARY_INDEX_CLASS ELFCLASS32
+#endif
+
+#if defined(__x86_64__)
+# define LIBRARY_INDEX_MACHINE EM_X86_64
+#elif defined(__i386__)
+# define LIBRARY_INDEX_MACHINE EM_386
+#elif defined(__aarch64__)
+# define LIBRARY_INDEX_MACHINE EM_AARCH64
+#elif defined(__arm__)
+# define LIBRARY_INDEX_MACHINE EM_ARM
+#elif defined(__powerpc64__)
+# define LIBRARY_INDEX_MACHINE EM_PPC64
+#elif defined(__powerpc__)
+# define LIBRARY_INDEX_MACHINE EM_PPC
+#elif defined(__s390__)
+# define LIBRARY_INDEX_MACHINE EM_S390
+#elif defined(__mips__)
+# define LIBRARY_INDEX_MACHINE EM_MIPS
+#elif defined(__riscv) && defined(EM_RISCV)
+# define LIBRARY_INDEX_MACHINE EM_RISCV
+#endif
+
+struct library_index_entry {
+    unsigned int hash;
+    const char * name;
+    const char * path;
+};
+
+static struct {
+    int valid;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    char base[FAKECHROOT_PATH_MAX];
+    char * data;
+    struct library_index_entry * table;
+    unsigned int mask;
+} library_index;
+static volatile int library_index_spinlock = 0;
+
+
+/* If the lock can't be taken, the index is not used */
+#define library_index_lock() fakechroot_lock(&library_index_spinlock)
+#define library_index_unlock() __sync_lock_release(&library_index_spinlock)
+
+
+static unsigned int library_index_hash(const char * name)
+{
+    unsigned int h = 5381;
+
+    while (*name)
+        h = h * 33 + (unsigned char)*name++;
+
+    return h;
+}
+
+
+static struct library_index_entry * library_index_find(struct library_index_entry * table, unsigned int mask, const char * name, unsigned int hash)
+{
+    unsigned int i;
+
+    for (i = hash & mask; table[i].name != NULL; i = (i + 1) & mask) {
+        if (table[i].hash == hash && strcmp(table[i].name, name) == 0) break;
+    }
+    return &table[i];
+}
+
+
+/* Reads the file and builds the hash table; the first entry for a name wins */
+static int library_index_load(const char * file, const struct STAT_T * st)
+{
+    struct library_index_entry * table, * e;
+    unsigned int mask = 15;
+    unsigned long class, machine;
+    size_t len = 0, lines = 1;
+    ssize_t n;
+    char * data, * p, * end, * name, * path;
+    int fd;
+
+    if ((fd = nextsyscall(open)(file, O_RDONLY, 0)) == -1) {
+        return -1;
+    }
+    if ((data = malloc(st->st_size + 1)) == NULL) {
+        close(fd);
+        return -1;
+    }
+    while (len < (size_t)st->st_size && (n = read(fd, data + len, st->st_size - len)) > 0) {
+        len += n;
+    }
+    close(fd);
+    data[len] = '\0';
+
+    for (p = data; *p; p++) {
+        if (*p == '\n') lines++;
+    }
+    while (mask < 2 * lines) {
+        mask = mask * 2 + 1;
+    }
+    if ((table = calloc(mask + 1, sizeof(*table))) == NULL) {
+        free(data);
+        return -1;
+    }
+
+    for (p = data; *p; p = end) {
+        if ((end = strchr(p, '\n')) != NULL) {
+            *end++ = '\0';
+        }
+        else {
+            end = p + strlen(p);
+        }
+
+        class = strtoul(p, &p, 10);
+        machine = strtoul(p, &p, 10);
+        if (*p != ' ' || (path = strchr(name = p + 1, ' ')) == NULL) continue;
+        *path++ = '\0';
+        if (*name == '\0' || *path != '/') continue;
+
+        if (class != LIBRARY_INDEX_CLASS) continue;
+#ifdef LIBRARY_INDEX_MACHINE
+        if (machine != LIBRARY_INDEX_MACHINE) continue;
+#endif
+
+        e = library_index_find(table, mask, name, library_index_hash(name));
+        if (e->name == NULL) {
+            e->hash = library_index_hash(name);
+            e->name = name;
+            e->path = path;
+        }
+    }
+
+    free(library_index.table);
+    free(library_index.data);
+    library_index.table = table;
+    library_index.data = data;
+    library_index.mask = mask;
+    library_index.dev = st->st_dev;
+    library_index.ino = st->st_ino;
+    library_index.size = st->st_size;
+    library_index.mtime = st->st_mtime;
+    library_index.valid = 1;
+
+    debug("library_index_load(\"%s\"): %zu lines", file, lines);
+    return 0;
+}
+
+
+/* Returns the path of the library in the fake chroot or NULL if it is not indexed */
+LOCAL char * library_index_lookup(const char * name, char * buf, size_t size)
+{
+    const char * base = getenv("FAKECHROOT_BASE");
+    char file[FAKECHROOT_PATH_MAX];
+    struct library_index_entry * e;
+    struct STAT_T st;
+    char * ret = NULL;
+
+    if (base == NULL || name == NULL || *name == '\0') {
+        return NULL;
+    }
+
+    snprintf(file, FAKECHROOT_PATH_MAX, "%s%s", base, LIBRARY_INDEX_FILE);
+    if (STAT(file, &st) != 0) {
+        return NULL;
+    }
+
+    if (!library_index_lock()) {
+        return NULL;
+    }
+
+    if (!library_index.valid || library_index.dev != st.st_dev || library_index.ino != st.st_ino ||
+        library_index.size != st.st_size || library_index.mtime != st.st_mtime ||
+        strcmp(library_index.base, base) != 0) {
+        library_index.valid = 0;
+        if (library_index_load(file, &st) == -1) {
+            library_index_unlock();
+            return NULL;
+        }
+        strlcpy(library_index.base, base, FAKECHROOT_PATH_MAX);
+    }
+
+    e = library_index_find(library_index.table, library_index.mask, name, library_index_hash(name));
+    if (e->name != NULL) {
+        strlcpy(buf, e->path, size);
+        ret = buf;
+    }
+
+    library_index_unlock();
+
+    debug("library_index_lookup(\"%s\"): %s", name, ret != NULL ? ret : "not found");
+    return ret;
+}
+
+
+/* The lock could be held by a thread which doesn't exist in the child,
+   in the middle of a change, so the index is loaded again */
+LOCAL void library_index_fork_child(void)
+{
+    if (library_index_spinlock) {
+        library_index.valid = 0;
+        library_index.data = NULL;
+        library_index.table = NULL;
+        library_index_unlock();
+    }
+}
@@ -25,44 +25,45 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include "libfakechroot.h"
+#include "direct_syscall.h"
 #include "lstat.h"
+#include "symlink_cache.h"
 
 
-wrapper(lstat, int, (int ver, const char * filename, struct stat * buf))
+wrapper(lstat, int, (const char * filename, struct stat * buf))
 {
-    debug("lstat(%d, \"%s\", &buf)", ver, filename);
+    char abs_filename[FAKECHROOT_PATH_MAX];
+
+    debug("lstat(\"%s\", &buf)", filename);
 
     if (!fakechroot_localdir(filename)) {
         if (filename != NULL) {
-            char abs_filename[FAKECHROOT_PATH_MAX];
             rel2abs(filename, abs_filename);
             filename = abs_filename;
         }
     }
 
-    return lstat_rel(ver, filename, buf);
+    return lstat_rel(filename, buf);
 }
 
 
 /* Prevent looping with realpath() */
 LOCAL int lstat_rel(const char * file_name, struct stat * buf)
 {
-    char fakechroot_abspath[FAKECHROOT_PATH_MAX];
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
-    char *fakechroot_path;
-    char tmp[FAKECHROOT_PATH_MAX];
+    struct symlink_cache_stat st;
     int retval;
-    READLINK_TYPE_RETURN status;
     const char *orig;
 
     debug("lstat_rel(\"%s\", &buf)", file_name);
     orig = file_name;
     expand_chroot_rel_path(file_name);
-    retval = nextcall(lstat)(file_name, buf);
+    retval = nextsyscall(lstat)(file_name, buf);
     /* deal with http://bugs.debian.org/561991 */
-    if ((buf->st_mode & S_IFMT) == S_IFLNK)
-        if ((status = readlink(orig, tmp, sizeof(tmp)-1)) != -1)
-            buf->st_size = status;
+    if (retval == 0 && (buf->st_mode & S_IFMT) == S_IFLNK) {
+        symlink_cache_stat_set(st, *buf);
+        buf->st_size = symlink_cache_size(orig, file_name, &st);
+    }
     return retval;
 }
 
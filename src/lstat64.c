@@ -31,6 +31,8 @@
 #include <unistd.h>
 
 #include "libfakechroot.h"
+#include "direct_syscall.h"
+#include "symlink_cache.h"
 
 
 wrapper(lstat64, int, (const char * file_name, struct stat64 * buf))
@@ -38,10 +40,9 @@ wrapper(lstat64, int, (const char * file_name, struct stat64 * buf))
     char fakechroot_abspath[FAKECHROOT_PATH_MAX];
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
     char *fakechroot_path;
-    char tmp[FAKECHROOT_PATH_MAX];
     char resolved[FAKECHROOT_PATH_MAX];
+    struct symlink_cache_stat st;
     int retval;
-    READLINK_TYPE_RETURN status;
     const char *orig;
 
     debug("lstat64(\"%s\", &buf)", file_name);
@@ -54,11 +55,12 @@ wrapper(lstat64, int, (const char * file_name, struct stat64 * buf))
 
     orig = file_name;
     expand_chroot_path(file_name);
-    retval = nextcall(lstat64)(file_name, buf);
+    retval = nextsyscall(lstat64)(file_name, buf);
     /* deal with http://bugs.debian.org/561991 */
-    if ((buf->st_mode & S_IFMT) == S_IFLNK)
-        if ((status = readlink(orig, tmp, sizeof(tmp)-1)) != -1)
-            buf->st_size = status;
+    if (retval == 0 && (buf->st_mode & S_IFMT) == S_IFLNK) {
+        symlink_cache_stat_set(st, *buf);
+        buf->st_size = symlink_cache_size(orig, file_name, &st);
+    }
     return retval;
 }
 
@@ -23,6 +23,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include "libfakechroot.h"
+#include "direct_syscall.h"
 
 
 wrapper(mkdir, int, (const char *pathname, mode_t mode))
@@ -31,5 +32,5 @@ wrapper(mkdir, int, (const char *pathname, mode_t mode))
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
     debug("mkdir(\"%s\", 0%o)", pathname, mode);
     expand_chroot_path(pathname);
-    return nextcall(mkdir)(pathname, mode);
+    return nextsyscall(mkdir)(pathname, mode);
 }
@@ -24,9 +24,13 @@
 
 #define _ATFILE_SOURCE
 #define _POSIX_C_SOURCE 200809L
+/* for syscall() */
+#define _DEFAULT_SOURCE
+#define _BSD_SOURCE
 #include <sys/types.h>
 #include <sys/stat.h>
 #include "libfakechroot.h"
+#include "direct_syscall.h"
 
 
 wrapper(mkdirat, int, (int dirfd, const char * pathname, mode_t mode))
@@ -35,7 +39,7 @@ wrapper(mkdirat, int, (int dirfd, const char * pathname, mode_t mode))
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
     debug("mkdirat(%d, \"%s\", 0%o)", dirfd, pathname, mode);
     expand_chroot_path_at(dirfd, pathname);
-    return nextcall(mkdirat)(dirfd, pathname, mode);
+    return nextsyscall(mkdirat)(dirfd, pathname, mode);
 }
 
 #else
@@ -24,6 +24,8 @@
 #include <stddef.h>
 #include <fcntl.h>
 #include "libfakechroot.h"
+#include "direct_syscall.h"
+#include "procself.h"
 
 
 wrapper_alias(open, int, (const char * pathname, int flags, ...))
@@ -31,18 +33,22 @@ wrapper_alias(open, int, (const char * pathname, int flags, ...))
     char fakechroot_abspath[FAKECHROOT_PATH_MAX];
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
 
+    const char *procpath;
     int mode = 0;
 
     va_list arg;
     va_start(arg, flags);
 
     debug("open(\"%s\", %d, ...)", pathname, flags);
-    expand_chroot_path(pathname);
+    if ((procpath = procself_path(pathname, fakechroot_buf, sizeof(fakechroot_buf))) != NULL)
+        pathname = procpath;
+    else
+        expand_chroot_path(pathname);
 
     if (flags & O_CREAT) {
         mode = va_arg(arg, int);
         va_end(arg);
     }
 
-    return nextcall(open)(pathname, flags, mode);
+    return nextsyscall(open)(pathname, flags, mode);
 }
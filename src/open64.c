@@ -27,6 +27,8 @@
 #include <stddef.h>
 #include <fcntl.h>
 #include "libfakechroot.h"
+#include "direct_syscall.h"
+#include "procself.h"
 
 
 wrapper_alias(open64, int, (const char * pathname, int flags, ...))
@@ -34,20 +36,24 @@ wrapper_alias(open64, int, (const char * pathname, int flags, ...))
     char fakechroot_abspath[FAKECHROOT_PATH_MAX];
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
 
+    const char *procpath;
     int mode = 0;
 
     va_list arg;
     va_start(arg, flags);
 
     debug("open64(\"%s\", %d, ...)", pathname, flags);
-    expand_chroot_path(pathname);
+    if ((procpath = procself_path(pathname, fakechroot_buf, sizeof(fakechroot_buf))) != NULL)
+        pathname = procpath;
+    else
+        expand_chroot_path(pathname);
 
     if (flags & O_CREAT) {
         mode = va_arg(arg, int);
         va_end(arg);
     }
 
-    return nextcall(open64)(pathname, flags, mode);
+    return nextsyscall(open64)(pathname, flags, mode);
 }
 
 #else
@@ -0,0 +1,314 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+/*
+ * Searches $PATH for execvp() and posix_spawnp().  The candidates are
+ * probed with faccessat(), so the expensive preparation of execve() is
+ * done only once, for the found file.
+ *
+ * A candidate matched by FAKECHROOT_CMD_SUBST is returned without the
+ * probe, because execve() substitutes it even if the file doesn't exist.
+ *
+ * The found file is remembered for the PATH string and the command name.
+ * The entry is validated with the device and inode numbers and mtime of
+ * the directory where the file was found, so a removed or replaced
+ * command is searched again.  Like the hash table of the shell, a command
+ * added later to a directory earlier in PATH is not noticed until the
+ * entry is forgotten.  The cache is private for the process and it is
+ * inherited by the child after fork().
+ */
+
+#include <config.h>
+
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+#define _DEFAULT_SOURCE
+#define _ATFILE_SOURCE
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libfakechroot.h"
+#include "strchrnul.h"
+#include "strlcpy.h"
+#include "path_cache.h"
+
+
+#define PATH_CACHE_SIZE 64
+
+struct path_cache_entry {
+    unsigned int hash;
+    unsigned long used;
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    long mtime_nsec;
+    /* PATH, the command and the found file, one after another */
+    char * key;
+    char * file;
+    char * found;
+};
+
+static struct path_cache_entry path_cache[PATH_CACHE_SIZE];
+static unsigned long path_cache_clock = 0;
+static volatile int path_cache_spinlock = 0;
+
+
+/* A busy lock means a miss, so a signal handler or a child after fork()
+   never waits for it */
+#define path_cache_trylock() (!__sync_lock_test_and_set(&path_cache_spinlock, 1))
+#define path_cache_unlock() __sync_lock_release(&path_cache_spinlock)
+
+/* faccessat() is wrapped only if it is available */
+#ifdef HAVE_FCHMODAT
+# define path_cache_access(path) faccessat(AT_FDCWD, (path), X_OK, AT_EACCESS)
+#else
+# define path_cache_access(path) access((path), X_OK)
+#endif
+
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+# define path_cache_mtime_nsec(st) ((st).st_mtim.tv_nsec)
+#else
+# define path_cache_mtime_nsec(st) 0
+#endif
+
+
+static unsigned int path_cache_hash(const char * path, const char * file)
+{
+    unsigned int h = 5381;
+
+    while (*path)
+        h = h * 33 + (unsigned char)*path++;
+    h = h * 33;
+    while (*file)
+        h = h * 33 + (unsigned char)*file++;
+
+    return h;
+}
+
+
+static struct path_cache_entry * path_cache_find(unsigned int hash, const char * path, const char * file)
+{
+    struct path_cache_entry * e;
+
+    for (e = path_cache; e < path_cache + PATH_CACHE_SIZE; e++) {
+        if (e->key != NULL && e->hash == hash && strcmp(e->key, path) == 0 && strcmp(e->file, file) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+
+/* The directory of the found file, "." for the empty element of PATH */
+static int path_cache_stat_dir(const char * found, struct stat * st)
+{
+    char dir[FAKECHROOT_PATH_MAX];
+    const char * slash = strrchr(found, '/');
+
+    if (slash == NULL) {
+        return stat(".", st);
+    }
+    if (slash == found) {
+        return stat("/", st);
+    }
+    if ((size_t)(slash - found) >= sizeof(dir)) {
+        return -1;
+    }
+    memcpy(dir, found, slash - found);
+    dir[slash - found] = '\0';
+    return stat(dir, st);
+}
+
+
+static void path_cache_add(unsigned int hash, const char * path, const char * file, const char * found, const struct stat * st)
+{
+    struct path_cache_entry * e, * victim;
+    size_t pathlen, filelen, foundlen;
+    char * newkey, * oldkey;
+
+    pathlen = strlen(path) + 1;
+    filelen = strlen(file) + 1;
+    foundlen = strlen(found) + 1;
+
+    if ((newkey = malloc(pathlen + filelen + foundlen)) == NULL) {
+        return;
+    }
+    memcpy(newkey, path, pathlen);
+    memcpy(newkey + pathlen, file, filelen);
+    memcpy(newkey + pathlen + filelen, found, foundlen);
+
+    if (!path_cache_trylock()) {
+        free(newkey);
+        return;
+    }
+    if ((victim = path_cache_find(hash, path, file)) == NULL) {
+        victim = path_cache;
+        for (e = path_cache; e < path_cache + PATH_CACHE_SIZE; e++) {
+            if (e->used < victim->used) {
+                victim = e;
+            }
+        }
+    }
+    oldkey = victim->key;
+    victim->hash = hash;
+    victim->used = ++path_cache_clock;
+    victim->dev = st->st_dev;
+    victim->ino = st->st_ino;
+    victim->mtime = st->st_mtime;
+    victim->mtime_nsec = path_cache_mtime_nsec(*st);
+    victim->key = newkey;
+    victim->file = newkey + pathlen;
+    victim->found = newkey + pathlen + filelen;
+    path_cache_unlock();
+
+    free(oldkey);
+}
+
+
+/*
+   Returns the file which would be executed by execvp() for the command
+   file and the search path.  NULL with errno set to ENOENT or EACCES is
+   returned if there is no such file, or with other errno if the search
+   failed.
+*/
+LOCAL char * path_cache_search(const char * file, const char * path, char * buf, size_t size)
+{
+    struct path_cache_entry * e;
+    struct stat st;
+    unsigned int hash;
+    int got_eacces = 0, found = 0;
+    const char * p, * startp;
+    char * cmd_subst = NULL;
+    char subst[FAKECHROOT_PATH_MAX];
+    size_t filelen = strlen(file);
+
+    hash = path_cache_hash(path, file);
+
+    if (path_cache_trylock()) {
+        if ((e = path_cache_find(hash, path, file)) != NULL) {
+            e->used = ++path_cache_clock;
+            strlcpy(buf, e->found, size);
+            found = 1;
+        }
+        path_cache_unlock();
+    }
+
+    if (found) {
+        if (path_cache_stat_dir(buf, &st) == 0 && path_cache_trylock()) {
+            if ((e = path_cache_find(hash, path, file)) != NULL && e->dev == st.st_dev && e->ino == st.st_ino &&
+                e->mtime == st.st_mtime && e->mtime_nsec == path_cache_mtime_nsec(st)) {
+                path_cache_unlock();
+                debug("path_cache_search(\"%s\") = \"%s\" (cached)", file, buf);
+                return buf;
+            }
+            path_cache_unlock();
+        }
+        path_cache_forget(file, path);
+    }
+
+    /* execve() doesn't substitute the command again for the substituted one */
+    if (getenv("FAKECHROOT_CMD_ORIG") == NULL) {
+        cmd_subst = getenv("FAKECHROOT_CMD_SUBST");
+    }
+
+    p = path;
+    do {
+        size_t dirlen;
+
+        startp = p;
+        p = strchrnul(startp, ':');
+        dirlen = p - startp;
+
+        if (dirlen + 1 + filelen >= size) {
+            continue;
+        }
+        if (dirlen == 0) {
+            /* The empty element means the current directory */
+            memcpy(buf, file, filelen + 1);
+        } else {
+            memcpy(buf, startp, dirlen);
+            buf[dirlen] = '/';
+            memcpy(buf + dirlen + 1, file, filelen + 1);
+        }
+
+        if (fakechroot_try_cmd_subst(cmd_subst, buf, subst)) {
+            debug("path_cache_search(\"%s\") = \"%s\" (substituted)", file, buf);
+            return buf;
+        }
+
+        if (path_cache_access(buf) == 0) {
+            if (path_cache_stat_dir(buf, &st) == 0) {
+                path_cache_add(hash, path, file, buf, &st);
+            }
+            debug("path_cache_search(\"%s\") = \"%s\"", file, buf);
+            return buf;
+        }
+
+        switch (errno) {
+        case EACCES:
+            got_eacces = 1;
+            break;
+        case ENOENT:
+        case ESTALE:
+        case ENOTDIR:
+            break;
+        default:
+            return NULL;
+        }
+    } while (*p++ != '\0');
+
+    __set_errno(got_eacces ? EACCES : ENOENT);
+    return NULL;
+}
+
+
+/* Drops the entry if the found file couldn't be executed */
+LOCAL void path_cache_forget(const char * file, const char * path)
+{
+    struct path_cache_entry * e;
+    char * oldkey = NULL;
+
+    /* if the lock is busy, execvp() will try every element of PATH again */
+    if (!path_cache_trylock()) {
+        return;
+    }
+    if ((e = path_cache_find(path_cache_hash(path, file), path, file)) != NULL) {
+        oldkey = e->key;
+        e->key = NULL;
+        e->used = 0;
+    }
+    path_cache_unlock();
+
+    free(oldkey);
+}
+
+
+/* The lock could be held by a thread which doesn't exist in the child,
+   in the middle of a change, so the cache is dropped */
+LOCAL void path_cache_fork_child(void)
+{
+    if (path_cache_spinlock) {
+        memset(path_cache, 0, sizeof(path_cache));
+        path_cache_unlock();
+    }
+}
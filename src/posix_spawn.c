@@ -58,6 +58,7 @@ wrapper(posix_spawn, int, (pid_t* pid, const char * filename,
     char substfilename[FAKECHROOT_PATH_MAX];
     char newfilename[FAKECHROOT_PATH_MAX];
     char argv0[FAKECHROOT_PATH_MAX];
+    char exeenv[sizeof("FAKECHROOT_EXE=") + FAKECHROOT_PATH_MAX];
     unsigned int i, j, n, newenvppos;
     unsigned int do_cmd_subst = 0;
     size_t sizeenvp;
@@ -89,7 +90,7 @@ wrapper(posix_spawn, int, (pid_t* pid, const char * filename,
     }
 
     /* Copy envp to newenvp */
-    newenvp = malloc( (sizeenvp + preserve_env_list_count + 1) * sizeof (char *) );
+    newenvp = malloc( (sizeenvp + preserve_env_list_count + 3) * sizeof (char *) );
     if (newenvp == NULL) {
         __set_errno(ENOMEM);
         return errno;
@@ -139,6 +140,7 @@ wrapper(posix_spawn, int, (pid_t* pid, const char * filename,
             if ((tp = strchr(tmpkey, '=')) != NULL) {
                 *tp = 0;
                 if (strcmp(tmpkey, "FAKECHROOT") == 0 ||
+                    strcmp(tmpkey, "FAKECHROOT_EXE") == 0 ||
                     (is_base_orig && strcmp(tmpkey, "FAKECHROOT_BASE") == 0))
                 {
                     goto skip2;
@@ -211,6 +213,10 @@ wrapper(posix_spawn, int, (pid_t* pid, const char * filename,
             newargv[n++] = argv0;
         }
         newargv[n] = filename;
+        /* The kernel sees the elfloader as the executable */
+        snprintf(exeenv, sizeof(exeenv), "FAKECHROOT_EXE=%s", filename);
+        newenvp[newenvppos++] = exeenv;
+        newenvp[newenvppos] = NULL;
 
         debug("nextcall(posix_spawn)(\"%s\", {\"%s\", \"%s\", ...}, {\"%s\", ...})", elfloader, newargv[0], newargv[n], newenvp[0]);
         status = nextcall(posix_spawn)(pid, elfloader, file_actions, attrp, (char * const *)newargv, newenvp);
@@ -267,6 +273,9 @@ wrapper(posix_spawn, int, (pid_t* pid, const char * filename,
         newargv[n++] = argv0;
     }
     newargv[n] = newfilename;
+    snprintf(exeenv, sizeof(exeenv), "FAKECHROOT_EXE=%s", newfilename);
+    newenvp[newenvppos++] = exeenv;
+    newenvp[newenvppos] = NULL;
     debug("nextcall(posix_spawn)(\"%s\", {\"%s\", \"%s\", \"%s\", ...}, {\"%s\", ...})", elfloader, newargv[0], newargv[1], newargv[n], newenvp[0]);
     status = nextcall(posix_spawn)(pid, elfloader, file_actions, attrp, (char * const *)newargv, newenvp);
 
@@ -31,6 +31,7 @@
 #include <alloca.h>
 #include "strchrnul.h"
 #include "libfakechroot.h"
+#include "path_cache.h"
 
 #define DEFAULT_PATH ":/usr/bin:/bin"
 
@@ -58,7 +59,9 @@ wrapper(posix_spawnp, int, (pid_t* pid, const char* file,
         return posix_spawn(pid, file, file_actions, attrp, argv, envp);
     } else {
         int got_eacces = 0;
+        int status;
         char *path, *p, *name;
+        char found[FAKECHROOT_PATH_MAX];
         size_t len;
         size_t pathlen;
 
@@ -78,6 +81,26 @@ wrapper(posix_spawnp, int, (pid_t* pid, const char* file,
 #endif
         }
 
+        /* Probe the candidates first and execute only the found one.  */
+        if (path_cache_search(file, path, found, sizeof(found)) == NULL)
+            return errno;
+
+        if ((status = posix_spawn(pid, found, file_actions, attrp, argv, envp)) == 0)
+            return 0;
+
+        switch (status) {
+        case EACCES:
+        case ENOENT:
+        case ESTALE:
+        case ENOTDIR:
+            /* The found file can't be executed (i.e. it is a directory or
+             its interpreter is missing): try every element like before.  */
+            path_cache_forget(file, path);
+            break;
+        default:
+            return status;
+        }
+
         len = strlen(file) + 1;
         pathlen = strlen(path);
         name = alloca(pathlen + len + 1);
@@ -0,0 +1,243 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+/*
+ * Virtual /proc/self: the magic symlinks exe, cwd, root and fd/N of
+ * /proc/self, /proc/thread-self and /proc/PID are answered with the fake
+ * paths.  They are never translated to the fake root, where they can't
+ * exist.  Opening a path through them never leaves the fake root.
+ *
+ * The executable is taken from FAKECHROOT_EXE set by execve() when the
+ * program is run via FAKECHROOT_ELFLOADER because then the kernel shows
+ * the loader.  Otherwise it is read once from the kernel.
+ */
+
+#include <config.h>
+
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+#define _DEFAULT_SOURCE
+#include <sys/types.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "libfakechroot.h"
+#include "direct_syscall.h"
+#include "readlink.h"
+#include "setenv.h"
+#include "strlcpy.h"
+#include "symlink_cache.h"
+#include "procself.h"
+
+
+#define PROCSELF_EXE  1
+#define PROCSELF_CWD  2
+#define PROCSELF_ROOT 3
+#define PROCSELF_FD   4
+
+/* Real path of the executable run via elfloader */
+static char procself_exe[FAKECHROOT_PATH_MAX];
+
+
+void procself_init (void) CONSTRUCTOR;
+void procself_init (void)
+{
+    char *exe = getenv("FAKECHROOT_EXE");
+
+    if (exe != NULL) {
+        strlcpy(procself_exe, exe, sizeof(procself_exe));
+        /* Children which are not run via elfloader shouldn't inherit it */
+        unsetenv("FAKECHROOT_EXE");
+    }
+}
+
+
+/*
+   Returns the kind of magic symlink or 0.  The rest of the path after the
+   symlink is returned in rest.
+*/
+static int procself_parse(const char * path, int * self, const char ** rest)
+{
+    const char *p;
+    int kind;
+
+    if (path == NULL || strncmp(path, "/proc/", 6) != 0)
+        return 0;
+
+    p = path + 6;
+    if (strncmp(p, "self/", 5) == 0) {
+        *self = 1;
+        p += 5;
+    }
+    else if (strncmp(p, "thread-self/", 12) == 0) {
+        *self = 1;
+        p += 12;
+    }
+    else if (*p >= '0' && *p <= '9') {
+        pid_t pid = 0;
+        for (; *p >= '0' && *p <= '9'; p++)
+            pid = pid * 10 + (*p - '0');
+        if (*p++ != '/')
+            return 0;
+        *self = pid == getpid();
+    }
+    else {
+        return 0;
+    }
+
+    if (strncmp(p, "exe", 3) == 0) {
+        kind = PROCSELF_EXE;
+        p += 3;
+    }
+    else if (strncmp(p, "cwd", 3) == 0) {
+        kind = PROCSELF_CWD;
+        p += 3;
+    }
+    else if (strncmp(p, "root", 4) == 0) {
+        kind = PROCSELF_ROOT;
+        p += 4;
+    }
+    else if (strncmp(p, "fd/", 3) == 0 && p[3] >= '0' && p[3] <= '9') {
+        kind = PROCSELF_FD;
+        for (p += 3; *p >= '0' && *p <= '9'; p++);
+    }
+    else {
+        return 0;
+    }
+
+    if (*p != '\0' && *p != '/')
+        return 0;
+
+    *rest = p;
+    return kind;
+}
+
+
+/* Narrowed target of the magic symlink which is the path up to rest */
+static char * procself_target(int kind, int self, const char * path, const char * rest, char * buf, size_t size)
+{
+    char link[FAKECHROOT_PATH_MAX];
+    int linksize;
+
+    if (self && kind == PROCSELF_EXE && *procself_exe) {
+        strlcpy(buf, procself_exe, size);
+    }
+    else if (self && kind == PROCSELF_CWD) {
+        return getcwd(buf, size);
+    }
+    else if (self && kind == PROCSELF_ROOT) {
+        strlcpy(buf, "/", size);
+        return buf;
+    }
+    else {
+        if ((size_t)(rest - path) >= sizeof(link))
+            return NULL;
+        memcpy(link, path, rest - path);
+        link[rest - path] = '\0';
+
+        /* the target of fd and cwd can change so only exe is cached */
+        if (self && kind == PROCSELF_EXE)
+            linksize = symlink_cache_readlink(link, NULL, buf, size);
+        else
+            linksize = nextsyscall(readlink)(link, buf, size - 1);
+        if (linksize == -1)
+            return NULL;
+        buf[linksize] = '\0';
+    }
+
+    narrow_chroot_path(buf);
+    return buf;
+}
+
+
+/*
+   Returns the real path which should be used instead of the magic symlink
+   or NULL if the path is not a magic symlink of this process.  Only exe
+   and fd/N are passed to the kernel.  root, cwd and the paths below the
+   symlinks are replaced with their fake targets and translated like any
+   other path, so they can't leave the fake root.
+*/
+LOCAL const char * procself_path(const char * path, char * buf, size_t size)
+{
+    char fakechroot_abspath[FAKECHROOT_PATH_MAX];
+    char fakechroot_buf[FAKECHROOT_PATH_MAX];
+    char tmp[FAKECHROOT_PATH_MAX];
+    const char *rest, *fakepath;
+    int self, kind;
+
+    if ((kind = procself_parse(path, &self, &rest)) == 0 || !self)
+        return NULL;
+
+    if (*rest == '\0' && kind == PROCSELF_EXE)
+        return *procself_exe ? procself_exe : path;
+    if (*rest == '\0' && kind == PROCSELF_FD)
+        return path;
+
+    if (procself_expand(path, tmp, sizeof(tmp)) == NULL)
+        return NULL;
+    /* /proc could be excluded, so the target is checked again */
+    if ((fakepath = procself_path(tmp, buf, size)) != NULL)
+        return fakepath;
+    fakepath = tmp;
+    expand_chroot_path(fakepath);
+    strlcpy(buf, fakepath, size);
+
+    debug("procself_path(\"%s\") = \"%s\"", path, buf);
+    return buf;
+}
+
+
+/* readlink() of the magic symlink or NULL if the path is not one */
+LOCAL char * procself_readlink(const char * path, char * buf, size_t size)
+{
+    const char *rest;
+    int self, kind;
+
+    if ((kind = procself_parse(path, &self, &rest)) == 0 || *rest != '\0')
+        return NULL;
+
+    debug("procself_readlink(\"%s\", &buf, %zd)", path, size);
+    return procself_target(kind, self, path, rest, buf, size);
+}
+
+
+/*
+   Replaces the magic symlink at the beginning of the path with its target.
+   Returns NULL if there is no magic symlink or it doesn't point to a path.
+*/
+LOCAL char * procself_expand(const char * path, char * buf, size_t size)
+{
+    const char *rest;
+    size_t len;
+    int self, kind;
+
+    if ((kind = procself_parse(path, &self, &rest)) == 0)
+        return NULL;
+
+    if (procself_target(kind, self, path, rest, buf, size) == NULL || *buf != '/')
+        return NULL;
+    len = strlen(buf);
+    if (len + strlen(rest) >= size)
+        return NULL;
+    strcpy(buf + len, rest);
+
+    debug("procself_expand(\"%s\") = \"%s\"", path, buf);
+    return buf;
+}
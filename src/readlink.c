@@ -23,6 +23,8 @@
 #include <sys/types.h>
 #include <stddef.h>
 #include "libfakechroot.h"
+#include "direct_syscall.h"
+#include "procself.h"
 
 
 wrapper(readlink, READLINK_TYPE_RETURN, (const char * path, char * buf, READLINK_TYPE_ARG3(bufsiz)))
@@ -30,7 +32,7 @@ wrapper(readlink, READLINK_TYPE_RETURN, (const char * path, char * buf, READLINK
     char fakechroot_abspath[FAKECHROOT_PATH_MAX];
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
 
-    int linksize;
+    ssize_t linksize;
     char tmp[FAKECHROOT_PATH_MAX], *tmpptr;
 
     const char *fakechroot_base = getenv("FAKECHROOT_BASE");
@@ -40,39 +42,40 @@ wrapper(readlink, READLINK_TYPE_RETURN, (const char * path, char * buf, READLINK
         errno = ENOENT;
         return -1;
     }
+
+    if (procself_readlink(path, tmp, FAKECHROOT_PATH_MAX) != NULL) {
+        linksize = strlen(tmp);
+        if ((size_t)linksize > bufsiz) {
+            linksize = bufsiz;
+        }
+        memcpy(buf, tmp, linksize);
+        return linksize;
+    }
+
     expand_chroot_path(path);
 
-    if ((linksize = nextcall(readlink)(path, tmp, FAKECHROOT_PATH_MAX-1)) == -1) {
+    if ((linksize = nextsyscall(readlink)(path, tmp, FAKECHROOT_PATH_MAX-1)) == -1) {
         return -1;
     }
     tmp[linksize] = '\0';
 
+    tmpptr = tmp;
     if (fakechroot_base != NULL) {
-        tmpptr = strstr(tmp, fakechroot_base);
-        if (tmpptr != tmp) {
-            tmpptr = tmp;
-        }
-        else if (tmp[strlen(fakechroot_base)] == '\0') {
-            tmpptr = "/";
-            linksize = strlen(tmpptr);
+        const size_t base_len = strlen(fakechroot_base);
+        if (strncmp(tmp, fakechroot_base, base_len) == 0) {
+            if (tmp[base_len] == '\0') {
+                tmpptr = "/";
+                linksize = 1;
+            }
+            else if (tmp[base_len] == '/') {
+                tmpptr = tmp + base_len;
+                linksize -= base_len;
+            }
         }
-        else if (tmp[strlen(fakechroot_base)] == '/') {
-            tmpptr = tmp + strlen(fakechroot_base);
-            linksize -= strlen(fakechroot_base);
-        }
-        else {
-            tmpptr = tmp;
-        }
-        if (strlen(tmpptr) > bufsiz) {
-            linksize = bufsiz;
-        }
-        strncpy(buf, tmpptr, linksize);
     }
-    else {
-        if (linksize > bufsiz) {
-            linksize = bufsiz;
-        }
-        strncpy(buf, tmp, linksize);
+    if ((size_t)linksize > bufsiz) {
+        linksize = bufsiz;
     }
+    memcpy(buf, tmpptr, linksize);
     return linksize;
 }
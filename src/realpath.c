@@ -20,31 +20,125 @@
 
 #include <config.h>
 
-#ifdef HAVE___LXSTAT64
-# define _LARGEFILE64_SOURCE
-#endif
-
+#define _GNU_SOURCE
 #include <stddef.h>
 #include <sys/stat.h>
 #ifdef HAVE_ALLOCA_H
 # include <alloca.h>
 #endif
 #include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <unistd.h>
 
 #include "libfakechroot.h"
+#include "direct_syscall.h"
+#include "open.h"
+#include "procself.h"
 #include "readlink.h"
+#include "strlcpy.h"
+#include "symlink_cache.h"
+
+#if defined(HAVE_LINUX_OPENAT2_H) && defined(HAVE_SYS_SYSCALL_H) && defined(O_PATH)
+# include <sys/syscall.h>
+# include <linux/openat2.h>
+# ifdef SYS_openat2
+#  define REALPATH_OPENAT2
+# endif
+#endif
+
+
+/*
+   The symlink size is not needed here so it is cheaper than lstat_rel().
+   The real path is stored in fakechroot_buf.  Prevent looping with
+   realpath().
+*/
+static int realpath_lstat(const char * path, struct symlink_cache_stat * st, char * fakechroot_buf)
+{
+    expand_chroot_rel_path(path);
+    if (path != fakechroot_buf)
+        strlcpy(fakechroot_buf, path, FAKECHROOT_PATH_MAX);
+    return symlink_cache_lstat(fakechroot_buf, st);
+}
+
+
+#ifdef REALPATH_OPENAT2
+
+/* Below this number of components the walk below is not cheaper */
+#define REALPATH_OPENAT2_MIN_COMPONENTS 5
+
+static int realpath_openat2_failed = 0;
+
+/*
+   Lets the kernel resolve the path inside the root directory: it takes
+   openat2(RESOLVE_IN_ROOT) and readlink() of /proc/self/fd/N regardless
+   of the number of components and symlinks.  Returns NULL if the result
+   can't be trusted and the path has to be resolved component by component.
+*/
+static char * realpath_openat2(const char * name, char * rpath, long int path_max)
+{
+    const char *fakechroot_base = getenv("FAKECHROOT_BASE");
+    struct open_how how;
+    char proc[32], *buf, *ptr;
+    const char *p;
+    size_t base_len;
+    int basefd, fd, n, components = 0;
+
+    if (realpath_openat2_failed || fakechroot_base == NULL || name[0] != '/')
+        return NULL;
+
+    for (p = name; *p; p++)
+        if (p[0] == '/' && p[1] != '/' && p[1] != '\0')
+            components++;
+    if (components < REALPATH_OPENAT2_MIN_COMPONENTS)
+        return NULL;
+
+    /* Excluded paths are resolved by the host, not inside the root */
+    if (fakechroot_localdir(name))
+        return NULL;
+
+    if ((basefd = nextsyscall(open)(fakechroot_base, O_PATH | O_DIRECTORY | O_CLOEXEC, 0)) == -1)
+        return NULL;
+
+    memset(&how, 0, sizeof(how));
+    how.flags = O_PATH | O_CLOEXEC;
+    how.resolve = RESOLVE_IN_ROOT | RESOLVE_NO_MAGICLINKS;
+    fd = syscall(SYS_openat2, basefd, name, &how, sizeof(how));
+    if (fd == -1 && (errno == ENOSYS || errno == EPERM))
+        realpath_openat2_failed = 1;
+    close(basefd);
+    if (fd == -1)
+        return NULL;
+
+    snprintf(proc, sizeof(proc), "/proc/self/fd/%d", fd);
+    buf = alloca(path_max);
+    n = nextsyscall(readlink)(proc, buf, path_max - 1);
+    close(fd);
+    if (n <= 0)
+        return NULL;
+    buf[n] = '\0';
+
+    base_len = strlen(fakechroot_base);
+    while (base_len > 0 && fakechroot_base[base_len - 1] == '/')
+        base_len--;
+    if (strncmp(buf, fakechroot_base, base_len) != 0)
+        return NULL;
+    if (buf[base_len] == '\0')
+        ptr = "/";
+    else if (buf[base_len] == '/')
+        ptr = buf + base_len;
+    else
+        return NULL;
+
+    /* The host could have another file there */
+    if (fakechroot_localdir(ptr))
+        return NULL;
+
+    debug("realpath_openat2(\"%s\") = \"%s\"", name, ptr);
+    memmove(rpath, ptr, strlen(ptr) + 1);
+    return rpath;
+}
 
-#ifdef HAVE___LXSTAT64
-# define _LARGEFILE64_SOURCE
-# include "__lxstat64.h"
-# define STAT_T stat64
-# define LSTAT_REL(rpath, st) __lxstat64_rel(_STAT_VER, rpath, st)
-#else
-# include "lstat.h"
-# define STAT_T stat
-# define LSTAT_REL(rpath, st) lstat_rel(rpath, st)
 #endif
 
 
@@ -67,7 +161,7 @@
 
 wrapper(realpath, char *, (const char * name, char * resolved))
 {
-    char *rpath, *dest, *extra_buf = NULL;
+    char *rpath, *dest, *extra_buf = NULL, *host = NULL, *procname;
     const char *start, *end, *rpath_limit;
     long int path_max;
     int num_links = 0;
@@ -91,6 +185,11 @@ wrapper(realpath, char *, (const char * name, char * resolved))
 
     path_max = FAKECHROOT_PATH_MAX;
 
+    /* The magic symlinks of /proc/self don't exist inside the root */
+    procname = alloca(path_max);
+    if (procname && procself_expand(name, procname, path_max) != NULL)
+        name = procname;
+
     if (resolved == NULL) {
         rpath = malloc(path_max);
         if (rpath == NULL) {
@@ -103,6 +202,11 @@ wrapper(realpath, char *, (const char * name, char * resolved))
         rpath = resolved;
     rpath_limit = rpath + path_max;
 
+#ifdef REALPATH_OPENAT2
+    if (realpath_openat2(name, rpath, path_max) != NULL)
+        return rpath;
+#endif
+
     if (name[0] != '/') {
         if (!getcwd(rpath, path_max)) {
             rpath[0] = '\0';
@@ -117,7 +221,7 @@ wrapper(realpath, char *, (const char * name, char * resolved))
     }
 
     for (start = end = name; *start; start = end) {
-        struct STAT_T st;
+        struct symlink_cache_stat st;
         int n;
 
         /* Skip sequence of multiple path-separators.  */
@@ -178,10 +282,18 @@ wrapper(realpath, char *, (const char * name, char * resolved))
             dest += end - start;
             *dest = '\0';
 
-            if (LSTAT_REL (rpath, &st) < 0)
+            if (!host) {
+                host = alloca(FAKECHROOT_PATH_MAX);
+                if (!host) {
+                    __set_errno(ENOMEM);
+                    goto error;
+                }
+            }
+
+            if (realpath_lstat(rpath, &st, host) < 0)
                 goto error;
 
-            if (S_ISLNK (st.st_mode)) {
+            if (S_ISLNK (st.mode)) {
                 char *buf;
                 size_t len;
 
@@ -196,13 +308,14 @@ wrapper(realpath, char *, (const char * name, char * resolved))
                     goto error;
                 }
 
-                n = readlink(rpath, buf, path_max - 1);
+                n = symlink_cache_readlink(host, &st, buf, path_max);
                 if (n < 0) {
                     int saved_errno = errno;
                     __set_errno(saved_errno);
                     goto error;
                 }
-                buf[n] = '\0';
+                narrow_chroot_path(buf);
+                n = strlen(buf);
 
                 if (!extra_buf) {
                     extra_buf = alloca(path_max);
@@ -235,7 +348,7 @@ wrapper(realpath, char *, (const char * name, char * resolved))
                             && *dest == '/')
                         dest++;
                 }
-            } else if (!S_ISDIR (st.st_mode) && *end != '\0') {
+            } else if (!S_ISDIR (st.mode) && *end != '\0') {
                 __set_errno(ENOTDIR);
                 goto error;
             }
@@ -0,0 +1,70 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+#include <config.h>
+
+#ifdef HAVE_RECVFROM
+
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef AF_UNIX
+
+#include <sys/un.h>
+
+#include "libfakechroot.h"
+#include "af_unix.h"
+
+#ifdef HAVE_RECVFROM_TYPE_ARG5___SOCKADDR_ARG__
+# define SOCKADDR(addr) ((addr).__sockaddr__)
+# define SOCKADDR_UN(addr) ((addr).__sockaddr_un__)
+#else
+# define SOCKADDR(addr) (addr)
+# define SOCKADDR_UN(addr) (addr)
+#endif
+
+
+wrapper(recvfrom, ssize_t, (int sockfd, RECVFROM_TYPE_ARG2(buf), size_t len, int flags, RECVFROM_TYPE_ARG5(addr), RECVFROM_TYPE_ARG6(addrlen)))
+{
+    ssize_t status;
+    socklen_t origlen;
+
+    if (SOCKADDR(addr) == NULL || addrlen == NULL) {
+        return nextcall(recvfrom)(sockfd, buf, len, flags, addr, addrlen);
+    }
+
+    origlen = *addrlen;
+    status = nextcall(recvfrom)(sockfd, buf, len, flags, addr, addrlen);
+    /* The address of the peer, not of this socket */
+    if (status != -1 && SOCKADDR(addr)->sa_family == AF_UNIX) {
+        debug("recvfrom(%d, &buf, %zu, %d, &addr, &addrlen)", sockfd, len, flags);
+        af_unix_narrow(-1, SOCKADDR_UN(addr), origlen, addrlen);
+    }
+
+    return status;
+}
+
+#else
+typedef int empty_translation_unit;
+#endif
+
+#else
+typedef int empty_translation_unit;
+#endif
@@ -0,0 +1,62 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+#include <config.h>
+
+#ifdef HAVE_RECVMSG
+
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef AF_UNIX
+
+#include <sys/un.h>
+
+#include "libfakechroot.h"
+#include "af_unix.h"
+
+
+wrapper(recvmsg, ssize_t, (int sockfd, struct msghdr * msg, int flags))
+{
+    ssize_t status;
+    socklen_t origlen;
+
+    if (msg->msg_name == NULL) {
+        return nextcall(recvmsg)(sockfd, msg, flags);
+    }
+
+    origlen = msg->msg_namelen;
+    status = nextcall(recvmsg)(sockfd, msg, flags);
+    /* The address of the peer, not of this socket */
+    if (status != -1 && ((struct sockaddr *)msg->msg_name)->sa_family == AF_UNIX) {
+        debug("recvmsg(%d, &msg, %d)", sockfd, flags);
+        af_unix_narrow(-1, msg->msg_name, origlen, &msg->msg_namelen);
+    }
+
+    return status;
+}
+
+#else
+typedef int empty_translation_unit;
+#endif
+
+#else
+typedef int empty_translation_unit;
+#endif
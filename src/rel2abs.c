@@ -46,8 +46,12 @@ LOCAL char * rel2abs(const char * name, char * resolved)
         goto end;
     }
 
-    getcwd_real(cwd, FAKECHROOT_PATH_MAX - 1);
-    narrow_chroot_path(cwd);
+    if (*name != '/') {
+        if (getcwd_real(cwd, FAKECHROOT_PATH_MAX - 1) == NULL) {
+            *cwd = '\0';
+        }
+        narrow_chroot_path(cwd);
+    }
 
     if (*name == '/') {
         strlcpy(resolved, name, FAKECHROOT_PATH_MAX);
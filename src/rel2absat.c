@@ -29,11 +29,40 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <fcntl.h>
+#include <string.h>
 
 #include "libfakechroot.h"
 #include "strlcpy.h"
 #include "dedotdot.h"
 #include "open.h"
+#include "readlink.h"
+#include "direct_syscall.h"
+
+
+#define PROC_SELF_FD "/proc/self/fd/"
+#define PROC_DELETED " (deleted)"
+
+/*
+   The directory of the descriptor is read from the kernel each time, so
+   it follows renames.  Returns NULL without /proc or if the directory
+   was removed.
+*/
+static char * rel2absat_procfd(int dirfd, char * buf, size_t size)
+{
+    char link[sizeof(PROC_SELF_FD) + 3 * sizeof(int)];
+    ssize_t linksize;
+
+    snprintf(link, sizeof(link), PROC_SELF_FD "%d", dirfd);
+    if ((linksize = nextsyscall(readlink)(link, buf, size - 1)) <= 0 || (size_t)linksize >= size - 1 || buf[0] != '/')
+        return NULL;
+    buf[linksize] = '\0';
+    if ((size_t)linksize > sizeof(PROC_DELETED) - 1 &&
+        strcmp(buf + linksize - (sizeof(PROC_DELETED) - 1), PROC_DELETED) == 0)
+        return NULL;
+
+    narrow_chroot_path(buf);
+    return buf;
+}
 
 
 LOCAL char * rel2absat(int dirfd, const char * name, char * resolved)
@@ -60,6 +89,8 @@ LOCAL char * rel2absat(int dirfd, const char * name, char * resolved)
             goto error;
         }
         snprintf(resolved, FAKECHROOT_PATH_MAX, "%s/%s", cwd, name);
+    } else if (rel2absat_procfd(dirfd, cwd, sizeof(cwd)) != NULL) {
+        snprintf(resolved, FAKECHROOT_PATH_MAX, "%s/%s", cwd, name);
     } else {
         if ((cwdfd = nextcall(open)(".", O_RDONLY|O_DIRECTORY)) == -1) {
             goto error;
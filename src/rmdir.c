@@ -21,6 +21,7 @@
 #include <config.h>
 
 #include "libfakechroot.h"
+#include "direct_syscall.h"
 
 
 wrapper(rmdir, int, (const char * pathname))
@@ -29,5 +30,5 @@ wrapper(rmdir, int, (const char * pathname))
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
     debug("rmdir(\"%s\")", pathname);
     expand_chroot_path(pathname);
-    return nextcall(rmdir)(pathname);
+    return nextsyscall(rmdir)(pathname);
 }
@@ -0,0 +1,75 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+#include <config.h>
+
+#ifdef HAVE_SENDMSG
+
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef AF_UNIX
+
+#include <sys/un.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "libfakechroot.h"
+#include "af_unix.h"
+
+
+wrapper(sendmsg, ssize_t, (int sockfd, const struct msghdr * msg, int flags))
+{
+    struct sockaddr_un newaddr_un;
+    struct msghdr newmsg;
+    ssize_t status;
+    int dirfd, saved_errno;
+
+    /* Connected sockets and other families go straight through */
+    if (msg->msg_name == NULL || ((const struct sockaddr *)msg->msg_name)->sa_family != AF_UNIX) {
+        return nextcall(sendmsg)(sockfd, msg, flags);
+    }
+
+    debug("sendmsg(%d, &msg, %d)", sockfd, flags);
+
+    newmsg = *msg;
+    switch (af_unix_translate(msg->msg_name, msg->msg_namelen, &newaddr_un, &newmsg.msg_namelen, &dirfd)) {
+    case 1:
+        return nextcall(sendmsg)(sockfd, msg, flags);
+    case -1:
+        return -1;
+    }
+    newmsg.msg_name = &newaddr_un;
+
+    status = nextcall(sendmsg)(sockfd, &newmsg, flags);
+    saved_errno = errno;
+    if (dirfd != -1)
+        close(dirfd);
+    __set_errno(saved_errno);
+    return status;
+}
+
+#else
+typedef int empty_translation_unit;
+#endif
+
+#else
+typedef int empty_translation_unit;
+#endif
@@ -0,0 +1,81 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+#include <config.h>
+
+#ifdef HAVE_SENDTO
+
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef AF_UNIX
+
+#include <sys/un.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "libfakechroot.h"
+#include "af_unix.h"
+
+#ifdef HAVE_SENDTO_TYPE_ARG5___CONST_SOCKADDR_ARG__
+# define SOCKADDR(addr) ((addr).__sockaddr__)
+# define SOCKADDR_UN(addr) ((addr).__sockaddr_un__)
+#else
+# define SOCKADDR(addr) (addr)
+# define SOCKADDR_UN(addr) (addr)
+#endif
+
+
+wrapper(sendto, ssize_t, (int sockfd, SENDTO_TYPE_ARG2(buf), size_t len, int flags, SENDTO_TYPE_ARG5(addr), socklen_t addrlen))
+{
+    struct sockaddr_un newaddr_un;
+    socklen_t newaddrlen;
+    ssize_t status;
+    int dirfd, saved_errno;
+
+    /* Connected sockets and other families go straight through */
+    if (SOCKADDR(addr) == NULL || SOCKADDR(addr)->sa_family != AF_UNIX) {
+        return nextcall(sendto)(sockfd, buf, len, flags, addr, addrlen);
+    }
+
+    debug("sendto(%d, &buf, %zu, %d, &addr, %d)", sockfd, len, flags, addrlen);
+
+    switch (af_unix_translate((const struct sockaddr_un *)SOCKADDR_UN(addr), addrlen, &newaddr_un, &newaddrlen, &dirfd)) {
+    case 1:
+        return nextcall(sendto)(sockfd, buf, len, flags, addr, addrlen);
+    case -1:
+        return -1;
+    }
+
+    status = nextcall(sendto)(sockfd, buf, len, flags, (struct sockaddr *)&newaddr_un, newaddrlen);
+    saved_errno = errno;
+    if (dirfd != -1)
+        close(dirfd);
+    __set_errno(saved_errno);
+    return status;
+}
+
+#else
+typedef int empty_translation_unit;
+#endif
+
+#else
+typedef int empty_translation_unit;
+#endif
@@ -51,84 +51,329 @@
 
 
 /* If this variable is not a null pointer we allocated the current
-   environment.  */
+   environment.  last_environ_size is its capacity.  */
 static char **last_environ;
+static size_t last_environ_size;
+
+
+/* The side index of the environment: the hash table of the names which
+   points to the slots of environ.  It is checked against environ before
+   use, so the changes done by libc functions or directly by the
+   application are noticed and the index is rebuilt.  */
+struct env_index_entry {
+        char *var;
+        size_t slot;
+        unsigned int hash;
+};
+
+static struct env_index_entry *env_index;
+static size_t env_index_size;
+static char **env_index_environ;
+static size_t env_index_count;
+static char *env_index_last;
+static int env_index_dups;
+static int env_index_built;
+
+/* The strings allocated by setenv().  They can't be freed because getenv()
+   could return them, but the same value is reused.  */
+static char **env_known;
+static size_t env_known_size;
+static size_t env_known_count;
+
+/* The writers wait for the lock.  getenv() is called by every wrapper,
+   also from signal handlers and in the child after fork(), where the lock
+   could be held by the interrupted or lost thread, so it doesn't wait: it
+   scans environ like libc does if the lock is busy.  */
+static volatile int env_spinlock = 0;
+
+#define env_lock() while (__sync_lock_test_and_set(&env_spinlock, 1))
+#define env_trylock() (!__sync_lock_test_and_set(&env_spinlock, 1))
+#define env_unlock() __sync_lock_release(&env_spinlock)
+
+
+static unsigned int env_hash(const char *s, size_t len)
+{
+        unsigned int h = 5381;
+
+        while (len--)
+                h = h * 33 + (unsigned char)*s++;
+
+        return h;
+}
+
+
+static int env_name_eq(const char *var, const char *name, size_t namelen)
+{
+        return !strncmp(var, name, namelen) && var[namelen] == '=';
+}
+
+
+static struct env_index_entry *env_index_find(const char *name, size_t namelen, unsigned int hash)
+{
+        size_t i, mask = env_index_size - 1;
+
+        for (i = hash & mask; env_index[i].var != NULL; i = (i + 1) & mask) {
+                if (env_index[i].hash == hash && env_name_eq(env_index[i].var, name, namelen))
+                        return &env_index[i];
+        }
+        return NULL;
+}
+
+
+static void env_index_insert(char *var, size_t slot)
+{
+        size_t namelen = strchrnul(var, '=') - var;
+        unsigned int hash = env_hash(var, namelen);
+        size_t i, mask = env_index_size - 1;
+
+        for (i = hash & mask; env_index[i].var != NULL; i = (i + 1) & mask) {
+                if (env_index[i].hash == hash && env_name_eq(env_index[i].var, var, namelen)) {
+                        /* getenv() returns the first one */
+                        env_index_dups = 1;
+                        return;
+                }
+        }
+        env_index[i].var = var;
+        env_index[i].slot = slot;
+        env_index[i].hash = hash;
+}
+
+
+/* Backward shift deletion, so there are no tombstones */
+static void env_index_delete(struct env_index_entry *e)
+{
+        size_t mask = env_index_size - 1;
+        size_t i = e - env_index, j = i, k;
+
+        for (;;) {
+                j = (j + 1) & mask;
+                if (env_index[j].var == NULL)
+                        break;
+                k = env_index[j].hash & mask;
+                /* move the entry back unless its home bucket is in (i, j] */
+                if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+                        continue;
+                env_index[i] = env_index[j];
+                i = j;
+        }
+        env_index[i].var = NULL;
+}
+
+
+/* Returns 0 if there is no memory for the index */
+static int env_index_rebuild(void)
+{
+        size_t count = 0, size = 16, i;
+        char **ep = __environ;
+
+        if (ep != NULL)
+                while (ep[count] != NULL)
+                        count++;
+
+        /* load factor at most 1/2 */
+        while (size < 2 * (count + 1))
+                size <<= 1;
+        if (size > env_index_size) {
+                struct env_index_entry *new_index = malloc(size * sizeof(struct env_index_entry));
+                if (new_index == NULL) {
+                        env_index_built = 0;
+                        return 0;
+                }
+                free(env_index);
+                env_index = new_index;
+                env_index_size = size;
+        }
+        memset(env_index, 0, env_index_size * sizeof(struct env_index_entry));
+
+        env_index_dups = 0;
+        for (i = 0; i < count; i++)
+                env_index_insert(ep[i], i);
+
+        env_index_environ = ep;
+        env_index_count = count;
+        env_index_last = count > 0 ? ep[count - 1] : NULL;
+        env_index_built = 1;
+        return 1;
+}
+
+
+/* The index is still valid if environ was not reallocated and the
+   number of variables and the last one are the same */
+static int env_index_valid(void)
+{
+        if (!env_index_built || __environ != env_index_environ)
+                return 0;
+        if (__environ == NULL)
+                return 1;
+        return __environ[env_index_count] == NULL &&
+                (env_index_count == 0 || __environ[env_index_count - 1] == env_index_last);
+}
+
+
+/* Finds the variable and makes sure the index is valid.  Returns 0 if
+   there is no index.  */
+static int env_index_lookup(const char *name, size_t namelen, struct env_index_entry **found)
+{
+        unsigned int hash = env_hash(name, namelen);
+        struct env_index_entry *e;
+
+        if (!env_index_valid() && !env_index_rebuild())
+                return 0;
+
+        e = env_index_find(name, namelen, hash);
+        if (e != NULL && (e->slot >= env_index_count || __environ[e->slot] != e->var)) {
+                /* the slot was changed behind our back */
+                if (!env_index_rebuild())
+                        return 0;
+                e = env_index_find(name, namelen, hash);
+        }
+        *found = e;
+        return 1;
+}
+
+
+static char *env_known_get(const char *name, size_t namelen, const char *value, size_t vallen)
+{
+        unsigned int hash = env_hash(name, namelen) ^ env_hash(value, vallen);
+        size_t i, mask = env_known_size - 1;
+        char *s;
+
+        if (env_known_size == 0)
+                return NULL;
+        for (i = hash & mask; (s = env_known[i]) != NULL; i = (i + 1) & mask) {
+                if (env_name_eq(s, name, namelen) && !memcmp(s + namelen + 1, value, vallen) && s[namelen + 1 + vallen] == '\0')
+                        return s;
+        }
+        return NULL;
+}
+
+
+static void env_known_add(char *s, size_t namelen, size_t vallen)
+{
+        size_t i, mask;
+
+        if (2 * (env_known_count + 1) > env_known_size) {
+                size_t size = env_known_size ? 2 * env_known_size : 64;
+                char **old = env_known, **new_known;
+                size_t old_size = env_known_size, j;
+
+                if ((new_known = calloc(size, sizeof(char *))) == NULL)
+                        return;
+                env_known = new_known;
+                env_known_size = size;
+                for (j = 0; j < old_size; j++) {
+                        if (old[j] != NULL) {
+                                size_t n = strchrnul(old[j], '=') - old[j];
+                                size_t v = strlen(old[j] + n + 1);
+                                unsigned int h = env_hash(old[j], n) ^ env_hash(old[j] + n + 1, v);
+                                for (i = h & (size - 1); env_known[i] != NULL; i = (i + 1) & (size - 1));
+                                env_known[i] = old[j];
+                        }
+                }
+                free(old);
+        }
+
+        mask = env_known_size - 1;
+        for (i = (env_hash(s, namelen) ^ env_hash(s + namelen + 1, vallen)) & mask; env_known[i] != NULL; i = (i + 1) & mask);
+        env_known[i] = s;
+        env_known_count++;
+}
+
+
+/* Appends the variable.  The array allocated by us grows geometrically.  */
+static int env_append(char *var)
+{
+        size_t count = env_index_count;
+
+        if (__environ == NULL || __environ != last_environ || count + 2 > last_environ_size) {
+                size_t size = last_environ_size ? last_environ_size : 16;
+                char **new_environ;
+
+                while (size < count + 2)
+                        size <<= 1;
+                if (__environ == last_environ) {
+                        new_environ = realloc(last_environ, size * sizeof(char *));
+                } else {
+                        if ((new_environ = malloc(size * sizeof(char *))) != NULL) {
+                                if (count > 0)
+                                        memcpy(new_environ, __environ, count * sizeof(char *));
+                                free(last_environ);
+                        }
+                }
+                if (new_environ == NULL) {
+                        __set_errno(ENOMEM);
+                        return -1;
+                }
+                last_environ = __environ = new_environ;
+                last_environ_size = size;
+                env_index_environ = new_environ;
+        }
+
+        __environ[count] = var;
+        __environ[count + 1] = NULL;
+        env_index_insert(var, count);
+        env_index_count = count + 1;
+        env_index_last = var;
+        return 0;
+}
 
 
 /* This function is used by `setenv' and `putenv'.  The difference between
    the two functions is that for the former must create a new string which
    is then placed in the environment, while the argument of `putenv'
-   must be used directly.  This is all complicated by the fact that we try
-   to reuse values once generated for a `setenv' call since we can never
-   free the strings. [in uclibc, we do not]  */
+   must be used directly.  The strings created by `setenv' are reused for
+   the same value because they can never be freed.  */
 static int __add_to_environ(const char *name, const char *value,
                 int replace)
 {
-        register char **ep;
-        register size_t size;
+        struct env_index_entry *e;
         char *var_val;
-        char **new_environ;
         /* name may come from putenv() and thus may contain "=VAL" part */
         const size_t namelen = strchrnul(name, '=') - name;
         int rv = -1;
 
-        /* We have to get the pointer now that we have the lock and not earlier
-           since another thread might have created a new environment.  */
-        ep = __environ;
-
-        size = 0;
-        if (ep != NULL) {
-                while (*ep != NULL) {
-                        if (!strncmp(*ep, name, namelen) && (*ep)[namelen] == '=') {
-                                /* Found */
-                                if (!replace)
-                                        goto DONE_OK;
-                                goto REPLACE;
-                        }
-                        ++size;
-                        ++ep;
-                }
-        }
-
-        /* Not found, add at the end */
+        env_lock();
 
-        /* We allocated this space; we can extend it.  */
-        new_environ = realloc(last_environ, (size + 2) * sizeof(char *));
-        if (new_environ == NULL) {
+        if (!env_index_lookup(name, namelen, &e)) {
                 __set_errno(ENOMEM);
                 goto DONE;
         }
-        if (__environ != last_environ) {
-                memcpy(new_environ, __environ, size * sizeof(char *));
-        }
-        last_environ = __environ = new_environ;
 
-        ep = &new_environ[size];
-        /* Ensure env is NULL terminated in case malloc below fails */
-        ep[0] = NULL;
-        ep[1] = NULL;
+        if (e != NULL && !replace)
+                goto DONE_OK;
 
- REPLACE:
         var_val = (char*) name;
         /* Build VAR=VAL if we called by setenv, not putenv.  */
         if (value != NULL) {
-                const size_t vallen = strlen(value) + 1;
+                const size_t vallen = strlen(value);
 
-                var_val = malloc(namelen + 1 + vallen);
-                if (var_val == NULL) {
-                        __set_errno(ENOMEM);
-                        goto DONE;
+                if ((var_val = env_known_get(name, namelen, value, vallen)) == NULL) {
+                        var_val = malloc(namelen + 1 + vallen + 1);
+                        if (var_val == NULL) {
+                                __set_errno(ENOMEM);
+                                goto DONE;
+                        }
+                        memcpy(var_val, name, namelen);
+                        var_val[namelen] = '=';
+                        memcpy(&var_val[namelen + 1], value, vallen + 1);
+                        env_known_add(var_val, namelen, vallen);
                 }
-                memcpy(var_val, name, namelen);
-                var_val[namelen] = '=';
-                memcpy(&var_val[namelen + 1], value, vallen);
         }
-        *ep = var_val;
+
+        if (e != NULL) {
+                __environ[e->slot] = var_val;
+                if (e->slot == env_index_count - 1)
+                        env_index_last = var_val;
+                e->var = var_val;
+        } else if (env_append(var_val) != 0) {
+                goto DONE;
+        }
 
  DONE_OK:
         rv = 0;
 
  DONE:
+        env_unlock();
         return rv;
 }
 
@@ -140,9 +385,10 @@ LOCAL int __setenv(const char *name, const char *value, int replace)
 
 LOCAL int __unsetenv(const char *name)
 {
+        struct env_index_entry *e, *moved;
         const char *eq;
-        size_t len;
-        char **ep;
+        size_t len, namelen, i, last;
+        char **ep, *var;
 
         if (name == NULL || *name == '\0'
          || *(eq = strchrnul(name, '=')) == '='
@@ -152,6 +398,28 @@ LOCAL int __unsetenv(const char *name)
         }
         len = eq - name; /* avoiding strlen this way */
 
+        env_lock();
+
+        if (env_index_lookup(name, len, &e) && !env_index_dups) {
+                if (e != NULL) {
+                        /* Shift the later variables down, libc keeps the order */
+                        last = env_index_count - 1;
+                        for (i = e->slot; i < last; i++) {
+                                var = __environ[i + 1];
+                                namelen = strchrnul(var, '=') - var;
+                                __environ[i] = var;
+                                if ((moved = env_index_find(var, namelen, env_hash(var, namelen))) != NULL)
+                                        moved->slot = i;
+                        }
+                        __environ[last] = NULL;
+                        env_index_delete(e);
+                        env_index_count = last;
+                        env_index_last = last > 0 ? __environ[last - 1] : NULL;
+                }
+                env_unlock();
+                return 0;
+        }
+
         ep = __environ;
         /* NB: clearenv(); unsetenv("foo"); should not segfault */
         if (ep) while (*ep != NULL) {
@@ -166,21 +434,65 @@ LOCAL int __unsetenv(const char *name)
                         ++ep;
                 }
         }
+        env_index_built = 0;
+
+        env_unlock();
         return 0;
 }
 
+/* The lock could be held by a thread which doesn't exist in the child */
+LOCAL void __env_fork_child(void)
+{
+        env_index_built = 0;
+        env_unlock();
+}
+
+/* getenv() which uses the index */
+LOCAL char *__getenv(const char *name)
+{
+        struct env_index_entry *e;
+        size_t len = strlen(name);
+        char *ret = NULL;
+        char **ep;
+
+        if (env_trylock()) {
+                if (env_index_lookup(name, len, &e)) {
+                        if (e != NULL)
+                                ret = e->var + len + 1;
+                        env_unlock();
+                        return ret;
+                }
+                env_unlock();
+        }
+
+        if ((ep = __environ) != NULL) {
+                for (; *ep != NULL; ep++) {
+                        if (env_name_eq(*ep, name, len)) {
+                                ret = *ep + len + 1;
+                                break;
+                        }
+                }
+        }
+
+        return ret;
+}
+
 /* The `clearenv' was planned to be added to POSIX.1 but probably
    never made it.  Nevertheless the POSIX.9 standard (POSIX bindings
    for Fortran 77) requires this function.  */
 LOCAL int __clearenv(void)
 {
+        env_lock();
         /* If we allocated this environment we can free it.
          * If we did not allocate this environment, it's NULL already
          * and is safe to free().  */
         free(last_environ);
         last_environ = NULL;
+        last_environ_size = 0;
         /* Clearing environ removes the whole environment.  */
         __environ = NULL;
+        env_index_built = 0;
+        env_unlock();
         return 0;
 }
 
@@ -25,10 +25,13 @@ int __setenv (const char *, const char *, int);
 int __unsetenv(const char *);
 int __clearenv(void);
 int __putenv(char *);
+char * __getenv(const char *);
+void __env_fork_child(void);
 
 #define setenv   __setenv
 #define unsetenv __unsetenv
 #define clearenv __clearenv
 #define putenv   __putenv
+#define getenv   __getenv
 
 #endif
@@ -29,13 +29,17 @@
 #include <stdlib.h>
 
 #include "libfakechroot.h"
+#include "direct_syscall.h"
 
 
 wrapper(stat, int, (const char * file_name, struct stat * buf))
 {
+    char fakechroot_abspath[FAKECHROOT_PATH_MAX];
+    char fakechroot_buf[FAKECHROOT_PATH_MAX];
+
     debug("stat(\"%s\", &buf)", file_name);
     expand_chroot_path(file_name);
-    return nextcall(stat)(file_name, buf);
+    return nextsyscall(stat)(file_name, buf);
 }
 
 #else
@@ -0,0 +1,311 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+/*
+ * Remembers the targets of symlinks.  The entry is indexed by the real
+ * path of the symlink and it is validated with the device and inode
+ * numbers, size and ctime returned by lstat(), because a symlink can't be
+ * modified, only replaced.  The target is stored as it was returned by
+ * the kernel, so it is narrowed again if FAKECHROOT_BASE has changed.
+ *
+ * The least recently used entry is replaced.  The hit rate is shown with
+ * FAKECHROOT_DEBUG.
+ */
+
+#include <config.h>
+
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+#define _DEFAULT_SOURCE
+#ifdef HAVE___LXSTAT64
+# define _LARGEFILE64_SOURCE
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libfakechroot.h"
+#include "direct_syscall.h"
+#include "procself.h"
+#include "readlink.h"
+#include "strlcpy.h"
+#include "symlink_cache.h"
+
+#ifdef HAVE___LXSTAT64
+# include "__lxstat64.h"
+# define STAT_T stat64
+# define LSTAT(path, st) nextcall(__lxstat64)(_STAT_VER, path, st)
+#else
+# include "lstat.h"
+# define STAT_T stat
+# define LSTAT(path, st) nextsyscall(lstat)(path, st)
+#endif
+
+
+#define SYMLINK_CACHE_SIZE 64
+
+struct symlink_cache_entry {
+    struct symlink_cache_stat st;
+    unsigned int hash;
+    unsigned long used;
+    char * path;
+    char * target;
+};
+
+static struct symlink_cache_entry symlink_cache[SYMLINK_CACHE_SIZE];
+static unsigned long symlink_cache_clock = 0;
+static unsigned long symlink_cache_hits = 0;
+static unsigned long symlink_cache_misses = 0;
+static volatile int symlink_cache_spinlock = 0;
+
+/* It doesn't change for the process */
+#define PROC_SELF_EXE "/proc/self/exe"
+static char proc_self_exe[FAKECHROOT_PATH_MAX];
+static int proc_self_exe_len = -1;
+
+
+/* A busy lock means a miss, so a signal handler or a child after fork()
+   never waits for it */
+#define symlink_cache_trylock() (!__sync_lock_test_and_set(&symlink_cache_spinlock, 1))
+#define symlink_cache_unlock() __sync_lock_release(&symlink_cache_spinlock)
+
+
+static unsigned int symlink_cache_hash(const char * path)
+{
+    unsigned int h = 5381;
+
+    while (*path)
+        h = h * 33 + (unsigned char)*path++;
+
+    return h;
+}
+
+
+static int symlink_cache_stat_eq(const struct symlink_cache_stat * a, const struct symlink_cache_stat * b)
+{
+    return a->dev == b->dev && a->ino == b->ino && a->size == b->size &&
+        a->ctime == b->ctime && a->ctime_nsec == b->ctime_nsec;
+}
+
+
+LOCAL int symlink_cache_lstat(const char * path, struct symlink_cache_stat * st)
+{
+    struct STAT_T buf;
+
+    if (LSTAT(path, &buf) == -1) {
+        return -1;
+    }
+
+    symlink_cache_stat_set(*st, buf);
+    return 0;
+}
+
+
+static void symlink_cache_add(const char * path, const struct symlink_cache_stat * st, const char * target)
+{
+    struct symlink_cache_entry * e, * victim;
+    unsigned int hash;
+    size_t pathlen, targetlen;
+    char * newpath, * oldpath;
+
+    if (path == NULL || *path != '/' || target == NULL) {
+        return;
+    }
+
+    pathlen = strlen(path) + 1;
+    targetlen = strlen(target) + 1;
+
+    /* the target is stored after the path */
+    if ((newpath = malloc(pathlen + targetlen)) == NULL) {
+        return;
+    }
+    memcpy(newpath, path, pathlen);
+    memcpy(newpath + pathlen, target, targetlen);
+
+    debug("symlink_cache_add(\"%s\", \"%s\")", path, target);
+
+    hash = symlink_cache_hash(path);
+
+    if (!symlink_cache_trylock()) {
+        free(newpath);
+        return;
+    }
+    victim = symlink_cache;
+    for (e = symlink_cache; e < symlink_cache + SYMLINK_CACHE_SIZE; e++) {
+        if (e->path != NULL && e->hash == hash && strcmp(e->path, path) == 0) {
+            victim = e;
+            break;
+        }
+        if (e->used < victim->used) {
+            victim = e;
+        }
+    }
+    oldpath = victim->path;
+    victim->st = *st;
+    victim->hash = hash;
+    victim->used = ++symlink_cache_clock;
+    victim->path = newpath;
+    victim->target = newpath + pathlen;
+    symlink_cache_unlock();
+
+    free(oldpath);
+}
+
+
+static char * symlink_cache_get(const char * path, const struct symlink_cache_stat * st, char * buf, size_t size)
+{
+    struct symlink_cache_entry * e;
+    unsigned int hash;
+    unsigned long hits, misses;
+    char * ret = NULL;
+
+    if (path == NULL) {
+        return NULL;
+    }
+
+    hash = symlink_cache_hash(path);
+
+    if (!symlink_cache_trylock()) {
+        return NULL;
+    }
+    for (e = symlink_cache; e < symlink_cache + SYMLINK_CACHE_SIZE; e++) {
+        if (e->path != NULL && e->hash == hash && strcmp(e->path, path) == 0) {
+            if (symlink_cache_stat_eq(&e->st, st)) {
+                e->used = ++symlink_cache_clock;
+                strlcpy(buf, e->target, size);
+                ret = buf;
+            }
+            break;
+        }
+    }
+    if (ret != NULL)
+        symlink_cache_hits++;
+    else
+        symlink_cache_misses++;
+    hits = symlink_cache_hits;
+    misses = symlink_cache_misses;
+    symlink_cache_unlock();
+
+    debug("symlink_cache_get(\"%s\") = \"%s\" (%lu hits, %lu misses)", path, ret ? ret : "(null)", hits, misses);
+    return ret;
+}
+
+
+/*
+   readlink() with the real path which uses the cache.  The result of
+   lstat() can be passed if it is already known.  The target is not
+   narrowed.
+*/
+LOCAL int symlink_cache_readlink(const char * path, const struct symlink_cache_stat * known, char * buf, size_t size)
+{
+    struct symlink_cache_stat st;
+    int linksize;
+
+    if (strcmp(path, PROC_SELF_EXE) == 0) {
+        if (proc_self_exe_len != -1 && symlink_cache_trylock()) {
+            strlcpy(buf, proc_self_exe, size);
+            symlink_cache_unlock();
+            return strlen(buf);
+        }
+        if ((linksize = nextsyscall(readlink)(path, buf, size - 1)) == -1) {
+            return -1;
+        }
+        buf[linksize] = '\0';
+        if (proc_self_exe_len == -1 && symlink_cache_trylock()) {
+            strlcpy(proc_self_exe, buf, sizeof(proc_self_exe));
+            proc_self_exe_len = linksize;
+            symlink_cache_unlock();
+        }
+        return linksize;
+    }
+
+    if (known != NULL) {
+        st = *known;
+    }
+    else if (symlink_cache_lstat(path, &st) == -1) {
+        return -1;
+    }
+    if (!S_ISLNK(st.mode)) {
+        __set_errno(EINVAL);
+        return -1;
+    }
+
+    if (symlink_cache_get(path, &st, buf, size) != NULL) {
+        return strlen(buf);
+    }
+
+    if ((linksize = nextsyscall(readlink)(path, buf, size - 1)) == -1) {
+        return -1;
+    }
+    buf[linksize] = '\0';
+
+    symlink_cache_add(path, &st, buf);
+    return linksize;
+}
+
+
+/*
+   Returns st_size of the symlink as it is seen in fake chroot, which is the
+   length of the narrowed target (http://bugs.debian.org/561991).  orig is
+   the path before translation and st is the result of lstat() of path.
+   The target is read only if it can start with FAKECHROOT_BASE.
+*/
+LOCAL off_t symlink_cache_size(const char * orig, const char * path, const struct symlink_cache_stat * st)
+{
+    char tmp[FAKECHROOT_PATH_MAX];
+    const char * fakechroot_base = getenv("FAKECHROOT_BASE");
+    size_t base_len = fakechroot_base != NULL ? strlen(fakechroot_base) : 0;
+    int linksize;
+
+    if (orig != NULL && procself_readlink(orig, tmp, FAKECHROOT_PATH_MAX) != NULL) {
+        return strlen(tmp);
+    }
+
+    /* procfs shows 0 so the target has to be read */
+    if (st->size > 0 && (base_len == 0 || (size_t)st->size < base_len)) {
+        return st->size;
+    }
+
+    if ((linksize = symlink_cache_readlink(path, st, tmp, FAKECHROOT_PATH_MAX)) == -1) {
+        return st->size;
+    }
+
+    if (base_len > 0 && strncmp(tmp, fakechroot_base, base_len) == 0) {
+        if (tmp[base_len] == '\0') {
+            return 1;
+        }
+        if (tmp[base_len] == '/') {
+            return linksize - base_len;
+        }
+    }
+    return linksize;
+}
+
+
+/* The lock could be held by a thread which doesn't exist in the child,
+   in the middle of a change, so the cache is dropped */
+LOCAL void symlink_cache_fork_child(void)
+{
+    if (symlink_cache_spinlock) {
+        memset(symlink_cache, 0, sizeof(symlink_cache));
+        symlink_cache_unlock();
+    }
+}
@@ -0,0 +1,64 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+#ifndef __SYMLINK_CACHE_H
+#define __SYMLINK_CACHE_H
+
+#include <config.h>
+#include <sys/types.h>
+
+
+/* Identity of the symlink: it can't be changed without changing these */
+struct symlink_cache_stat {
+    dev_t dev;
+    ino_t ino;
+    mode_t mode;
+    off_t size;
+    time_t ctime;
+    long ctime_nsec;
+};
+
+#ifdef HAVE_STRUCT_STAT_ST_CTIM_TV_NSEC
+# define symlink_cache_stat_set(s, st) \
+    { \
+        (s).dev = (st).st_dev; \
+        (s).ino = (st).st_ino; \
+        (s).mode = (st).st_mode; \
+        (s).size = (st).st_size; \
+        (s).ctime = (st).st_ctim.tv_sec; \
+        (s).ctime_nsec = (st).st_ctim.tv_nsec; \
+    }
+#else
+# define symlink_cache_stat_set(s, st) \
+    { \
+        (s).dev = (st).st_dev; \
+        (s).ino = (st).st_ino; \
+        (s).mode = (st).st_mode; \
+        (s).size = (st).st_size; \
+        (s).ctime = (st).st_ctime; \
+        (s).ctime_nsec = 0; \
+    }
+#endif
+
+int symlink_cache_lstat(const char *, struct symlink_cache_stat *);
+int symlink_cache_readlink(const char *, const struct symlink_cache_stat *, char *, size_t);
+off_t symlink_cache_size(const char *, const char *, const struct symlink_cache_stat *);
+void symlink_cache_fork_child(void);
+
+#endif
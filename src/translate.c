@@ -0,0 +1,129 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+/*
+ * The rules for translating paths between the fake chroot and the host.
+ * They are shared by libfakechroot and fakechroot-supervisor, so both
+ * sides agree on FAKECHROOT_EXCLUDE_PATH and the prefix of
+ * FAKECHROOT_BASE.  Only absolute paths are handled here.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libfakechroot.h"
+#include "translate.h"
+
+
+#define TRANSLATE_EXCLUDE_SIZE 100
+
+
+/* Useful to exclude a list of directories or files */
+static char * translate_exclude_list[TRANSLATE_EXCLUDE_SIZE];
+static size_t translate_exclude_length[TRANSLATE_EXCLUDE_SIZE];
+static int translate_exclude_count = 0;
+
+
+/* Parses FAKECHROOT_EXCLUDE_PATH=dir:dir:... */
+LOCAL void translate_exclude_init (const char * exclude_path)
+{
+    int i, j;
+
+    if (exclude_path == NULL)
+        return;
+
+    for (i = 0; translate_exclude_count < TRANSLATE_EXCLUDE_SIZE; ) {
+        for (j = i; exclude_path[j] != ':' && exclude_path[j] != '\0'; j++);
+        if (j > i && (translate_exclude_list[translate_exclude_count] = strndup(&exclude_path[i], j - i)) != NULL) {
+            translate_exclude_length[translate_exclude_count] = j - i;
+            translate_exclude_count++;
+        }
+        if (exclude_path[j] != ':')
+            break;
+        i = j + 1;
+    }
+}
+
+
+/* Returns non-zero if the absolute path is on the exclude list */
+LOCAL int translate_excluded (const char * path)
+{
+    const size_t len = strlen(path);
+    int i;
+
+    for (i = 0; i < translate_exclude_count; i++) {
+        const size_t n = translate_exclude_length[i];
+        if (n > len || path[n - 1] != translate_exclude_list[i][n - 1] ||
+                strncmp(translate_exclude_list[i], path, n) != 0)
+            continue;
+        if (n == len || path[n] == '/')
+            return 1;
+    }
+    return 0;
+}
+
+
+/* Returns non-zero if the host path is inside of the fake chroot */
+LOCAL int translate_has_base (const char * base, const char * path)
+{
+    size_t len;
+
+    if (base == NULL)
+        return 0;
+    len = strlen(base);
+    return strncmp(path, base, len) == 0 && (path[len] == '/' || path[len] == '\0');
+}
+
+
+/*
+   Prefixes the absolute path with base.  Returns 1 if buf holds the host
+   path, 0 if there is no fake chroot and -1 if the path was truncated.
+   The exclude list is checked by the caller.
+*/
+LOCAL int translate_expand (const char * base, const char * path, char * buf, size_t size)
+{
+    if (base == NULL)
+        return 0;
+    return (size_t)snprintf(buf, size, "%s%s", base, path) < size ? 1 : -1;
+}
+
+
+/* Removes the prefix of base from the host path in place */
+LOCAL void translate_narrow (const char * base, char * path)
+{
+    size_t base_len, path_len;
+
+    if (path == NULL || *path == '\0' || base == NULL)
+        return;
+
+    base_len = strlen(base);
+    if (strncmp(path, base, base_len) != 0)
+        return;
+
+    path_len = strlen(path);
+    if (path_len == base_len) {
+        path[0] = '/';
+        path[1] = '\0';
+    }
+    else if (path[base_len] == '/') {
+        memmove(path, path + base_len, 1 + path_len - base_len);
+    }
+}
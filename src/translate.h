@@ -0,0 +1,31 @@
+/*
+    libfakechroot -- fake chroot environment
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+
+#ifndef __TRANSLATE_H
+#define __TRANSLATE_H
+
+#include <stddef.h>
+
+void translate_exclude_init(const char *);
+int translate_excluded(const char *);
+int translate_has_base(const char *, const char *);
+int translate_expand(const char *, const char *, char *, size_t);
+void translate_narrow(const char *, char *);
+
+#endif
@@ -21,6 +21,7 @@
 #include <config.h>
 
 #include "libfakechroot.h"
+#include "direct_syscall.h"
 
 
 wrapper(unlink, int, (const char * pathname))
@@ -29,5 +30,5 @@ wrapper(unlink, int, (const char * pathname))
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
     debug("unlink(\"%s\")", pathname);
     expand_chroot_path(pathname);
-    return nextcall(unlink)(pathname);
+    return nextsyscall(unlink)(pathname);
 }
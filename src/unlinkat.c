@@ -24,6 +24,7 @@
 
 #define _ATFILE_SOURCE
 #include "libfakechroot.h"
+#include "direct_syscall.h"
 
 
 wrapper(unlinkat, int, (int dirfd, const char * pathname, int flags))
@@ -32,7 +33,7 @@ wrapper(unlinkat, int, (int dirfd, const char * pathname, int flags))
     char fakechroot_buf[FAKECHROOT_PATH_MAX];
     debug("unlinkat(%d, \"%s\", %d)", dirfd, pathname, flags);
     expand_chroot_path_at(dirfd, pathname);
-    return nextcall(unlinkat)(dirfd, pathname, flags);
+    return nextsyscall(unlinkat)(dirfd, pathname, flags);
 }
 
 #else
@@ -30,5 +30,14 @@ prepare () {
     unset FAKECHROOT_CMD_SUBST FAKECHROOT_DEBUG FAKECHROOT_EXCLUDE_PATH
 }
 
+# mktree dir dirs files [command]: creates dirs directories with files
+# entries each, which are created with touch or the command
+mktree () {
+    for mktree_d in `$SEQ 1 $2`; do
+        mkdir -p $1/d$mktree_d
+        ( cd $1/d$mktree_d && $SEQ 1 $3 | sed 's/^/f/' | xargs ${4:-touch} )
+    done
+}
+
 . "$srcdir/seq.inc.sh"
 . "$srcdir/tap.inc.sh"
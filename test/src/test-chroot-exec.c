@@ -0,0 +1,27 @@
+#define _BSD_SOURCE
+#define _DEFAULT_SOURCE
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Calls chroot() for each newroot in order and executes the command */
+int main (int argc, char *argv[]) {
+    int i;
+
+    for (i = 1; i < argc && strcmp(argv[i], "--") != 0; i++) {
+        if (chroot(argv[i]) == -1) {
+            perror("chroot");
+            exit(1);
+        }
+    }
+
+    if (i + 1 >= argc) {
+        fprintf(stderr, "Usage: %s newroot... -- command [arg...]\n", argv[0]);
+        exit(2);
+    }
+
+    execv(argv[i + 1], argv + i + 1);
+    perror("execv");
+    exit(1);
+}
@@ -4,11 +4,20 @@
 #include <stdlib.h>
 
 int main (int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s command\n", argv[0]);
+    int i, count = 1;
+
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: %s command [count]\n", argv[0]);
         exit(2);
     }
 
+    if (argc == 3)
+        count = atoi(argv[2]);
+
+    for (i = 0; i < count; i++) {
+        clearenv();
+        setenv("CLEARED", "again", 1);
+    }
     clearenv();
 
     if (system(argv[1]) == -1) {
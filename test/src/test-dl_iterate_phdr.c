@@ -0,0 +1,146 @@
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <link.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Prints the name of the module loaded from filename as reported by
+ * dl_iterate_phdr(), after it is called from the threads at the same time
+ * with two different callbacks, and checks that every callback gets its own
+ * data.  The name is kept from the first call, so it has to stay valid.
+ * The name kept by the loader is the real path, which must not be changed.
+ */
+
+#define ITERATIONS 1000
+#define MODULES 64
+
+struct search {
+    const char *filename;
+    const char *found;
+    int calls;
+    int odd;
+    int wrong;
+    const char *names[MODULES];
+};
+
+static int callback (struct dl_phdr_info *info, size_t size, void *data) {
+    struct search *s = data;
+    const char *base = strrchr(info->dlpi_name, '/');
+
+    (void)size;
+    if (s->calls < MODULES)
+        s->names[s->calls] = info->dlpi_name;
+    s->calls++;
+    if (base != NULL && strcmp(base + 1, s->filename) == 0)
+        s->found = info->dlpi_name;
+    return 0;
+}
+
+static int callback_even (struct dl_phdr_info *info, size_t size, void *data) {
+    struct search *s = data;
+
+    if (s->odd)
+        s->wrong = 1;
+    return callback(info, size, data);
+}
+
+static int callback_odd (struct dl_phdr_info *info, size_t size, void *data) {
+    struct search *s = data;
+
+    if (!s->odd)
+        s->wrong = 1;
+    return callback(info, size, data);
+}
+
+static void *run (void *arg) {
+    struct search *s = arg;
+    int i;
+
+    for (i = 0; i < ITERATIONS; i++) {
+        s->found = NULL;
+        s->calls = 0;
+        dl_iterate_phdr(s->odd ? callback_odd : callback_even, s);
+        if (s->found == NULL || s->calls == 0 || s->wrong)
+            return s;
+    }
+    return NULL;
+}
+
+int main (int argc, char *argv[]) {
+    struct search main_search, *searches;
+    struct link_map *map;
+    void *handle;
+    pthread_t *threads;
+    int i, n, failed = 0;
+    void *ret;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s filename threads\n", argv[0]);
+        exit(2);
+    }
+
+    if ((handle = dlopen(argv[1], RTLD_NOW)) == NULL) {
+        fprintf(stderr, "dlopen: %s\n", dlerror());
+        exit(1);
+    }
+
+    /* the name is saved on the first call and printed at the end */
+    main_search.filename = argv[1];
+    main_search.found = NULL;
+    main_search.calls = 0;
+    dl_iterate_phdr(callback, &main_search);
+    if (main_search.found == NULL) {
+        fprintf(stderr, "%s: not found\n", argv[1]);
+        exit(1);
+    }
+
+    n = atoi(argv[2]);
+    threads = calloc(n, sizeof(pthread_t));
+    searches = calloc(n, sizeof(struct search));
+    if (threads == NULL || searches == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+
+    for (i = 0; i < n; i++) {
+        searches[i].filename = argv[1];
+        searches[i].odd = i % 2;
+        if (pthread_create(&threads[i], NULL, run, &searches[i]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    for (i = 0; i < n; i++) {
+        if (pthread_join(threads[i], &ret) != 0 || ret != NULL)
+            failed++;
+    }
+    if (failed) {
+        fprintf(stderr, "%d threads failed\n", failed);
+        exit(1);
+    }
+
+    /* every module keeps its own name */
+    for (i = 1; i < main_search.calls && i < MODULES; i++) {
+        for (n = 0; n < i; n++) {
+            if (main_search.names[i][0] != '\0' && strcmp(main_search.names[i], main_search.names[n]) == 0) {
+                fprintf(stderr, "%s: reported twice\n", main_search.names[i]);
+                exit(1);
+            }
+        }
+    }
+
+    if (dlinfo(handle, RTLD_DI_LINKMAP, &map) != 0) {
+        fprintf(stderr, "dlinfo: %s\n", dlerror());
+        exit(1);
+    }
+    if (map->l_name == main_search.found || strcmp(map->l_name, main_search.found) == 0) {
+        fprintf(stderr, "dl_iterate_phdr: %s changed by the wrapper\n", map->l_name);
+        exit(1);
+    }
+    printf("%s\n", main_search.found);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <link.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/*
+ * Prints the path of the library which is loaded and contains the symbol.
+ * The name kept by the loader is the real path, which dladdr() must not
+ * change.  With a count, the library is loaded again as many times, at
+ * another address each time.
+ */
+int main (int argc, char *argv[]) {
+    void *handle, *sym;
+    Dl_info info, info2;
+    struct link_map *map;
+    int i, count = 1;
+
+    if (argc != 3 && argc != 4) {
+        fprintf(stderr, "Usage: %s filename symbol [count]\n", argv[0]);
+        exit(2);
+    }
+    if (argc == 4)
+        count = atoi(argv[3]);
+
+    for (i = 1; i < count; i++) {
+        if ((handle = dlopen(argv[1], RTLD_NOW)) == NULL || (sym = dlsym(handle, argv[2])) == NULL) {
+            fprintf(stderr, "dlopen: %s\n", dlerror());
+            exit(1);
+        }
+        if (dladdr(sym, &info) == 0 || dlinfo(handle, RTLD_DI_LINKMAP, &map) != 0 || strcmp(map->l_name, info.dli_fname) == 0) {
+            fprintf(stderr, "dladdr: %d: %s changed by the wrapper\n", i, info.dli_fname);
+            exit(1);
+        }
+        dlclose(handle);
+        /* the next library is mapped below this one */
+        if (mmap(NULL, 1 << 20, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) == MAP_FAILED) {
+            perror("mmap");
+            exit(1);
+        }
+    }
+
+    if ((handle = dlopen(argv[1], RTLD_NOW)) == NULL) {
+        fprintf(stderr, "dlopen: %s\n", dlerror());
+        exit(1);
+    }
+
+    if ((sym = dlsym(handle, argv[2])) == NULL) {
+        fprintf(stderr, "dlsym: %s\n", dlerror());
+        exit(1);
+    }
+
+    if (dladdr(sym, &info) == 0 || info.dli_fname == NULL) {
+        fprintf(stderr, "dladdr: %s\n", dlerror());
+        exit(1);
+    }
+
+    /* the second call gives the cached name */
+    if (dladdr(sym, &info2) == 0 || info2.dli_fname == NULL || strcmp(info.dli_fname, info2.dli_fname) != 0) {
+        fprintf(stderr, "dladdr: %s != %s\n", info.dli_fname, info2.dli_fname ? info2.dli_fname : "(null)");
+        exit(1);
+    }
+
+    if (dlinfo(handle, RTLD_DI_LINKMAP, &map) != 0) {
+        fprintf(stderr, "dlinfo: %s\n", dlerror());
+        exit(1);
+    }
+    if (map->l_name == info.dli_fname || strcmp(map->l_name, info.dli_fname) == 0) {
+        fprintf(stderr, "dladdr: %s changed by the wrapper\n", map->l_name);
+        exit(1);
+    }
+    printf("%s\n", info.dli_fname);
+
+    return 0;
+}
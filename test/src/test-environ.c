@@ -0,0 +1,34 @@
+#define _BSD_SOURCE
+#define _DEFAULT_SOURCE
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * With a command, sets empty FAKECHROOT_CMD_ORIG before three variables
+ * and runs the command, so execve() of libfakechroot unsets it.  Without
+ * a command, prints the names of these variables in the order of environ.
+ */
+
+extern char **environ;
+
+int main (int argc, char *argv[]) {
+    char **ep;
+
+    if (argc > 1) {
+        setenv("FAKECHROOT_CMD_ORIG", "", 1);
+        setenv("TEST_ENVIRON_1", "1", 1);
+        setenv("TEST_ENVIRON_2", "2", 1);
+        setenv("TEST_ENVIRON_3", "3", 1);
+        execvp(argv[1], argv + 1);
+        perror("execvp");
+        exit(1);
+    }
+
+    for (ep = environ; *ep != NULL; ep++) {
+        if (strncmp(*ep, "TEST_ENVIRON_", 13) == 0)
+            printf("%.*s\n", (int)strcspn(*ep, "="), *ep);
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+#define _BSD_SOURCE
+#define _DEFAULT_SOURCE
+#include <sys/time.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+ * Measures the cost of execve() which fails, i.e. the wrapper's work
+ * before the kernel is called: FAKECHROOT_CMD_SUBST lookup, path
+ * translation and copying the environment.  Prints nanoseconds per call.
+ */
+
+extern char **environ;
+
+int main (int argc, char *argv[]) {
+    struct timeval start, end;
+    char * const args[] = { argv[2], NULL };
+    long i, iterations;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s iterations /path/to/missing/command\n", argv[0]);
+        exit(2);
+    }
+
+    iterations = atol(argv[1]);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < iterations; i++)
+        execve(argv[2], args, environ);
+    gettimeofday(&end, NULL);
+
+    printf("%ld\n", ((end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_usec - start.tv_usec) * 1000L) / (iterations > 0 ? iterations : 1));
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#define _BSD_SOURCE
+#define _DEFAULT_SOURCE
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fts.h>
+
+#include <errno.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+ * Measures the cost of fts_read() with the given options over the whole
+ * tree: opening the directories and stating the entries.  Prints
+ * nanoseconds per entry.
+ */
+
+int main (int argc, char *argv[]) {
+    struct timeval start, end;
+    FTS *tree;
+    FTSENT *node;
+    long entries = 0;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s options path [path...]\n", argv[0]);
+        exit(2);
+    }
+
+    gettimeofday(&start, NULL);
+    if ((tree = fts_open(argv + 2, atoi(argv[1]), 0)) == NULL) {
+        perror("fts_open");
+        exit(1);
+    }
+    errno = 0;
+    while ((node = fts_read(tree)) != NULL)
+        entries++;
+    if (errno) {
+        perror("fts_read");
+        exit(1);
+    }
+    fts_close(tree);
+    gettimeofday(&end, NULL);
+
+    printf("%ld\n", ((end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_usec - start.tv_usec) * 1000L) / (entries > 0 ? entries : 1));
+
+    return 0;
+}
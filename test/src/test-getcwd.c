@@ -0,0 +1,48 @@
+#define _BSD_SOURCE
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Changes the directory with chdir() or with fchdir() for "fd:dir", or
+   renames a directory for "mv:from:to", and prints getcwd() */
+int main (int argc, char *argv[]) {
+    char *cwd, *to;
+    int i, fd;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s [fd:]dir|mv:from:to...\n", argv[0]);
+        exit(2);
+    }
+
+    for (i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "fd:", 3) == 0) {
+            if ((fd = open(argv[i] + 3, O_RDONLY | O_DIRECTORY)) == -1 || fchdir(fd) == -1) {
+                perror("fchdir");
+                exit(1);
+            }
+            close(fd);
+        }
+        else if (strncmp(argv[i], "mv:", 3) == 0 && (to = strchr(argv[i] + 3, ':')) != NULL) {
+            *to++ = '\0';
+            if (rename(argv[i] + 3, to) == -1) {
+                perror("rename");
+                exit(1);
+            }
+        }
+        else if (chdir(argv[i]) == -1) {
+            perror("chdir");
+            exit(1);
+        }
+        if ((cwd = getcwd(NULL, 0)) == NULL) {
+            perror("getcwd");
+            exit(1);
+        }
+        printf("%s\n", cwd);
+        free(cwd);
+    }
+
+    return 0;
+}
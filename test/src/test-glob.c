@@ -0,0 +1,32 @@
+#include <glob.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+
+int main (int argc, char *argv[]) {
+    glob_t g;
+    size_t i;
+    int flags = GLOB_DOOFFS;
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s pattern [pattern...]\n", argv[0]);
+        exit(2);
+    }
+
+    g.gl_offs = 2;
+    for (i = 1; i < (size_t)argc; i++) {
+        if (glob(argv[i], flags, NULL, &g) != 0) {
+            fprintf(stderr, "glob: %s: no match\n", argv[i]);
+            exit(1);
+        }
+        flags |= GLOB_APPEND;
+    }
+
+    for (i = 0; i < g.gl_pathc; i++) {
+        printf("%s\n", g.gl_pathv[g.gl_offs + i]);
+    }
+
+    globfree(&g);
+    return 0;
+}
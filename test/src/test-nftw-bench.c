@@ -0,0 +1,45 @@
+#define _XOPEN_SOURCE 500
+#define _BSD_SOURCE
+#define _DEFAULT_SOURCE
+#include <sys/time.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+ * Measures the cost of nftw() with the given flags over the whole tree.
+ * Prints nanoseconds per entry.
+ */
+
+static long entries = 0;
+
+static int callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf) {
+    (void)fpath;
+    (void)sb;
+    (void)typeflag;
+    (void)ftwbuf;
+    entries++;
+    return 0;
+}
+
+
+int main (int argc, char *argv[]) {
+    struct timeval start, end;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s flags path\n", argv[0]);
+        exit(2);
+    }
+
+    gettimeofday(&start, NULL);
+    if (nftw(argv[2], callback, 16, atoi(argv[1])) == -1) {
+        perror("nftw");
+        exit(1);
+    }
+    gettimeofday(&end, NULL);
+
+    printf("%ld\n", ((end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_usec - start.tv_usec) * 1000L) / (entries > 0 ? entries : 1));
+
+    return 0;
+}
@@ -0,0 +1,30 @@
+#define _XOPEN_SOURCE 500
+#include <ftw.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+
+static int callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf) {
+    printf("%s %d %d %ld\n", fpath, typeflag, ftwbuf->level, (long)sb->st_size);
+    return 0;
+}
+
+
+int main (int argc, char *argv[]) {
+    int flags;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s flags path\n", argv[0]);
+        exit(2);
+    }
+
+    flags = atoi(argv[1]);
+
+    if (nftw(argv[2], callback, 4, flags) == -1) {
+        perror("nftw");
+        exit(1);
+    }
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+
+/* With from and to, the directory is renamed between the calls */
+int main (int argc, char *argv[]) {
+    char buf[256];
+    ssize_t len;
+    int dirfd, fd, i;
+
+    if (argc != 3 && argc != 5) {
+        fprintf(stderr, "Usage: %s dir path [from to]\n", argv[0]);
+        exit(2);
+    }
+
+    if ((dirfd = open(argv[1], O_RDONLY | O_DIRECTORY)) == -1) {
+        perror("open");
+        exit(1);
+    }
+
+    /* the second call can use the remembered path of dirfd */
+    for (i = 0; i < 2; i++) {
+        if ((fd = openat(dirfd, argv[2], O_RDONLY)) == -1) {
+            perror("openat");
+            exit(1);
+        }
+        if ((len = read(fd, buf, sizeof(buf) - 1)) == -1) {
+            perror("read");
+            exit(1);
+        }
+        buf[len] = '\0';
+        printf("%s", buf);
+        close(fd);
+
+        if (i == 0 && argc == 5 && rename(argv[3], argv[4]) == -1) {
+            perror("rename");
+            exit(1);
+        }
+    }
+
+    close(dirfd);
+    return 0;
+}
@@ -0,0 +1,37 @@
+#define _BSD_SOURCE
+#define _DEFAULT_SOURCE
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* Replaces the symlink with each target and reads it back in one process */
+int main (int argc, char *argv[]) {
+    char buf[1024];
+    ssize_t sz;
+    int i;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s /path/to/symlink target...\n", argv[0]);
+        exit(2);
+    }
+
+    for (i = 2; i < argc; i++) {
+        if (unlink(argv[1]) == -1 && i > 2) {
+            perror("unlink");
+            exit(1);
+        }
+        if (symlink(argv[i], argv[1]) == -1) {
+            perror("symlink");
+            exit(1);
+        }
+        if ((sz = readlink(argv[1], buf, sizeof(buf) - 1)) < 0 ||
+            (sz = readlink(argv[1], buf, sizeof(buf) - 1)) < 0) {
+            perror("readlink");
+            exit(1);
+        }
+        buf[sz] = '\0';
+        printf("%s\n", buf);
+    }
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+#define _BSD_SOURCE
+#define _DEFAULT_SOURCE
+#include <sys/time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+ * Measures the cost of realpath() of the same path called again and again,
+ * like module lookups do.  Prints nanoseconds per call.
+ */
+
+int main (int argc, char *argv[]) {
+    struct timeval start, end;
+    char buf[PATH_MAX];
+    long i, iterations;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s iterations path\n", argv[0]);
+        exit(2);
+    }
+
+    iterations = atol(argv[1]);
+
+    gettimeofday(&start, NULL);
+    for (i = 0; i < iterations; i++) {
+        if (realpath(argv[2], buf) == NULL) {
+            perror("realpath");
+            exit(1);
+        }
+    }
+    gettimeofday(&end, NULL);
+
+    printf("%ld\n", ((end.tv_sec - start.tv_sec) * 1000000000L + (end.tv_usec - start.tv_usec) * 1000L) / (iterations > 0 ? iterations : 1));
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+#define _BSD_SOURCE
+#define _DEFAULT_SOURCE
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+ * Changes the environment with the functions of libc, so the index of
+ * libfakechroot has to notice it, then sets the variable and runs the
+ * command.
+ */
+
+int main (int argc, char *argv[]) {
+    char name[32];
+    int i, count;
+
+    if (argc < 5) {
+        fprintf(stderr, "Usage: %s count name value command [arg...]\n", argv[0]);
+        exit(2);
+    }
+
+    count = atoi(argv[1]);
+
+    for (i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "TEST_SETENV_%d", i);
+        setenv(name, "first", 1);
+    }
+    for (i = 0; i < count; i += 2) {
+        snprintf(name, sizeof(name), "TEST_SETENV_%d", i);
+        unsetenv(name);
+    }
+
+    setenv(argv[2], "wrong", 1);
+    for (i = 1; i < count; i += 2) {
+        snprintf(name, sizeof(name), "TEST_SETENV_%d", i);
+        setenv(name, "second", 1);
+    }
+    setenv(argv[2], argv[3], 1);
+
+    execvp(argv[4], argv + 4);
+
+    perror("execvp");
+    exit(1);
+}
@@ -0,0 +1,121 @@
+#define _GNU_SOURCE
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+ * Calls access() in a loop while a timer calls it from a signal handler,
+ * then forks children which call it while another thread does the same.
+ * The thread and the children call readlink() and dladdr() too, so the
+ * caches are used at fork().  A wrapper which waits for a lock held by the
+ * interrupted thread or by a thread which doesn't exist in the child never
+ * returns, so alarm() ends the process.
+ */
+
+#define ITERATIONS 100000
+#define FORKS 200
+
+static const char *path;
+static volatile sig_atomic_t missing = 0;
+static volatile int stop = 0;
+
+static void handler (int sig) {
+    (void)sig;
+    if (access(path, F_OK) != 0) {
+        missing = 1;
+    }
+}
+
+static int caches (void) {
+    char buf[256];
+    Dl_info info;
+
+    readlink(path, buf, sizeof(buf));
+    if (dladdr((void *)access, &info) == 0) {
+        return -1;
+    }
+    return access(path, F_OK);
+}
+
+static void *thread (void *arg) {
+    (void)arg;
+    while (!stop) {
+        caches();
+    }
+    return NULL;
+}
+
+int main (int argc, char *argv[]) {
+    struct sigaction sa;
+    struct itimerval it;
+    pthread_t t;
+    pid_t pid;
+    int i, status, failed = 0;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s path\n", argv[0]);
+        exit(2);
+    }
+    path = argv[1];
+
+    alarm(60);
+
+    sa.sa_handler = handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, NULL);
+
+    it.it_interval.tv_sec = 0;
+    it.it_interval.tv_usec = 100;
+    it.it_value = it.it_interval;
+    setitimer(ITIMER_PROF, &it, NULL);
+
+    for (i = 0; i < ITERATIONS; i++) {
+        if (access(path, F_OK) != 0) {
+            perror("access");
+            exit(1);
+        }
+    }
+
+    it.it_value.tv_usec = 0;
+    setitimer(ITIMER_PROF, &it, NULL);
+
+    if (pthread_create(&t, NULL, thread, NULL) != 0) {
+        perror("pthread_create");
+        exit(1);
+    }
+
+    for (i = 0; i < FORKS; i++) {
+        if ((pid = fork()) == -1) {
+            perror("fork");
+            exit(1);
+        }
+        if (pid == 0) {
+            alarm(5);
+            _exit(caches() == 0 ? 0 : 1);
+        }
+        if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failed++;
+        }
+    }
+
+    stop = 1;
+    pthread_join(t, NULL);
+
+    if (missing) {
+        printf("access() failed in the signal handler\n");
+    }
+    else if (failed) {
+        printf("%d children failed\n", failed);
+    }
+    else {
+        printf("ok\n");
+    }
+    return 0;
+}
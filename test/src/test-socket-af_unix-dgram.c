@@ -0,0 +1,91 @@
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef SUN_LEN
+#define SUN_LEN(su) (sizeof(*(su)) - sizeof((su)->sun_path) + strlen((su)->sun_path))
+#endif
+
+static int bind_dgram(const char *path, struct sockaddr_un *addr) {
+    int sockfd;
+
+    if ((sockfd = socket(AF_UNIX, SOCK_DGRAM, 0)) < 0) {
+        perror("socket");
+        exit(1);
+    }
+
+    memset((char *) addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, path);
+    if (bind(sockfd, (struct sockaddr *)addr, SUN_LEN(addr)) < 0) {
+        perror("bind");
+        exit(1);
+    }
+
+    return sockfd;
+}
+
+int main(int argc, char *argv[]) {
+    int servfd, clifd, n;
+    struct sockaddr_un serv_addr, cli_addr, from_addr;
+    socklen_t fromlen;
+    struct msghdr msg;
+    struct iovec iov;
+    char buffer[80];
+
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s server-path client-path message\n", argv[0]);
+        exit(2);
+    }
+
+    servfd = bind_dgram(argv[1], &serv_addr);
+    clifd = bind_dgram(argv[2], &cli_addr);
+
+    if (sendto(clifd, argv[3], strlen(argv[3]), 0, (struct sockaddr *)&serv_addr, SUN_LEN(&serv_addr)) < 0) {
+        perror("sendto");
+        exit(1);
+    }
+
+    memset((char *) &from_addr, 0, sizeof(from_addr));
+    fromlen = sizeof(from_addr);
+    if ((n = recvfrom(servfd, buffer, sizeof(buffer) - 1, 0, (struct sockaddr *)&from_addr, &fromlen)) < 0) {
+        perror("recvfrom");
+        exit(1);
+    }
+    buffer[n] = '\0';
+    printf("recvfrom: %s %s\n", buffer, from_addr.sun_path);
+
+    memset((char *) &msg, 0, sizeof(msg));
+    iov.iov_base = argv[3];
+    iov.iov_len = strlen(argv[3]);
+    msg.msg_name = &serv_addr;
+    msg.msg_namelen = SUN_LEN(&serv_addr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (sendmsg(clifd, &msg, 0) < 0) {
+        perror("sendmsg");
+        exit(1);
+    }
+
+    memset((char *) &from_addr, 0, sizeof(from_addr));
+    memset((char *) &msg, 0, sizeof(msg));
+    iov.iov_base = buffer;
+    iov.iov_len = sizeof(buffer) - 1;
+    msg.msg_name = &from_addr;
+    msg.msg_namelen = sizeof(from_addr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if ((n = recvmsg(servfd, &msg, 0)) < 0) {
+        perror("recvmsg");
+        exit(1);
+    }
+    buffer[n] = '\0';
+    printf("recvmsg: %s %s\n", buffer, from_addr.sun_path);
+
+    return 0;
+}
@@ -36,11 +36,12 @@ int main(int argc, char *argv[]) {
         exit(1);
     }
 
-    namelen = SUN_LEN(&name_addr);
+    namelen = sizeof(name_addr);
     if (getsockname(sockfd, (struct sockaddr*)&name_addr, &namelen) < 0) {
         perror("getsockname");
         exit(1);
     }
+    fprintf(stderr, "getsockname: %s\n", name_addr.sun_path);
 
     listen(sockfd, 1);
     clilen = sizeof(cli_addr);
@@ -0,0 +1,40 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* Statically linked cat(1) for testing the seccomp supervisor */
+
+int main (int argc, char *argv[]) {
+    char buf[4096];
+    ssize_t n;
+    int fd;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s path\n", argv[0]);
+        exit(2);
+    }
+
+    if ((fd = open(argv[1], O_RDONLY)) == -1) {
+        perror("open");
+        exit(1);
+    }
+
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        if (write(STDOUT_FILENO, buf, n) != n) {
+            perror("write");
+            exit(1);
+        }
+    }
+
+    if (n == -1) {
+        perror("read");
+        exit(1);
+    }
+
+    close(fd);
+
+    return 0;
+}
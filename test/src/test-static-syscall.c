@@ -0,0 +1,48 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Statically linked path syscalls for testing the seccomp supervisor */
+
+int main (int argc, char *argv[]) {
+    int fd, ret;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s chdir|chmod|creat|mkdir|rename|symlink path [path]\n", argv[0]);
+        exit(2);
+    }
+
+    if (!strcmp(argv[1], "chdir"))
+        ret = chdir(argv[2]);
+    else if (!strcmp(argv[1], "chmod"))
+        ret = chmod(argv[2], 0600);
+    else if (!strcmp(argv[1], "creat")) {
+        umask(0);
+        if ((ret = fd = creat(argv[2], 0666)) != -1)
+            close(fd);
+    }
+    else if (!strcmp(argv[1], "mkdir")) {
+        umask(0);
+        ret = mkdir(argv[2], 0777);
+    }
+    else if (!strcmp(argv[1], "rename") && argc == 4)
+        ret = rename(argv[2], argv[3]);
+    else if (!strcmp(argv[1], "symlink") && argc == 4)
+        ret = symlink(argv[2], argv[3]);
+    else {
+        fprintf(stderr, "%s: unknown syscall\n", argv[1]);
+        exit(2);
+    }
+
+    if (ret == -1) {
+        perror(argv[1]);
+        exit(1);
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,159 @@
+#define _BSD_SOURCE
+#define _GNU_SOURCE
+#define _DEFAULT_SOURCE
+#include <sys/types.h>
+#include <sys/ptrace.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fts.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/*
+ * Counts the syscalls issued by one call of a wrapped function.
+ *
+ * The scenario runs in a traced child between two SIGUSR1 markers.  It is
+ * run once with zero iterations and once with ITERATIONS iterations, so the
+ * cost of the markers and of the setup cancels out.  The result is the
+ * rounded average number of syscalls per call.
+ */
+
+#define ITERATIONS 100
+
+static const char *scenarios[] = {
+    "access", "chdir", "execve", "execvp", "faccessat", "fts-logical", "fts-physical", "getcwd", "lstat",
+    "readlink", "realpath", "stat", NULL
+};
+
+static void walk (const char *path, int options)
+{
+    char * const paths[] = { (char *)path, NULL };
+    FTS *tree;
+
+    if ((tree = fts_open(paths, options, NULL)) == NULL)
+        return;
+    while (fts_read(tree) != NULL);
+    fts_close(tree);
+}
+
+static void run_scenario (const char *scenario, const char *path, int iterations)
+{
+    char buf[4096];
+    char * const argv[] = { (char *)path, NULL };
+    struct stat st;
+    int dirfd = open(".", O_RDONLY | O_DIRECTORY);
+    int i;
+
+    raise(SIGUSR1);
+
+    for (i = 0; i < iterations; i++) {
+        if (!strcmp(scenario, "access"))
+            access(path, F_OK);
+        else if (!strcmp(scenario, "chdir"))
+            chdir(path);
+        else if (!strcmp(scenario, "execve"))
+            execve(path, argv, NULL);
+        else if (!strcmp(scenario, "execvp"))
+            execvp(path, argv);
+        else if (!strcmp(scenario, "faccessat"))
+            faccessat(dirfd, path, F_OK, 0);
+        else if (!strcmp(scenario, "fts-logical"))
+            walk(path, FTS_LOGICAL);
+        else if (!strcmp(scenario, "fts-physical"))
+            walk(path, FTS_PHYSICAL);
+        else if (!strcmp(scenario, "getcwd"))
+            getcwd(buf, sizeof(buf));
+        else if (!strcmp(scenario, "lstat"))
+            lstat(path, &st);
+        else if (!strcmp(scenario, "readlink"))
+            readlink(path, buf, sizeof(buf));
+        else if (!strcmp(scenario, "realpath"))
+            realpath(path, buf);
+        else if (!strcmp(scenario, "stat"))
+            stat(path, &st);
+    }
+
+    raise(SIGUSR1);
+}
+
+static long count_syscalls (const char *scenario, const char *path, int iterations)
+{
+    pid_t pid;
+    int status, sig = 0, markers = 0;
+    long stops = 0;
+
+    if ((pid = fork()) == -1) {
+        perror("fork");
+        exit(1);
+    }
+
+    if (pid == 0) {
+        if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) == -1)
+            _exit(3);
+        raise(SIGSTOP);
+        run_scenario(scenario, path, iterations);
+        _exit(0);
+    }
+
+    if (waitpid(pid, &status, 0) == -1 || !WIFSTOPPED(status))
+        return -1;
+    if (ptrace(PTRACE_SETOPTIONS, pid, NULL, (void *)PTRACE_O_TRACESYSGOOD) == -1)
+        return -1;
+
+    for (;;) {
+        if (ptrace(PTRACE_SYSCALL, pid, NULL, (void *)(long)sig) == -1)
+            return -1;
+        if (waitpid(pid, &status, 0) == -1)
+            return -1;
+        sig = 0;
+        if (WIFEXITED(status) || WIFSIGNALED(status))
+            break;
+        if (WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+            if (markers == 1)
+                stops++;
+        }
+        else if (WSTOPSIG(status) == SIGUSR1) {
+            markers++;
+        }
+        else {
+            sig = WSTOPSIG(status);
+        }
+    }
+
+    if (markers != 2)
+        return -1;
+
+    /* every syscall gives an entry and an exit stop */
+    return stops / 2;
+}
+
+int main (int argc, char *argv[]) {
+    const char **s;
+    long base, total;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s scenario path\n", argv[0]);
+        exit(2);
+    }
+
+    for (s = scenarios; *s != NULL && strcmp(*s, argv[1]) != 0; s++);
+    if (*s == NULL) {
+        fprintf(stderr, "%s: unknown scenario\n", argv[1]);
+        exit(2);
+    }
+
+    if ((base = count_syscalls(argv[1], argv[2], 0)) == -1 ||
+        (total = count_syscalls(argv[1], argv[2], ITERATIONS)) == -1) {
+        printf("skip\n");
+        return 0;
+    }
+
+    printf("%ld\n", (total - base + ITERATIONS / 2) / ITERATIONS);
+
+    return 0;
+}
@@ -3,7 +3,7 @@
 srcdir=${srcdir:-.}
 . $srcdir/common.inc.sh
 
-prepare 10
+prepare 14
 
 for chroot in chroot fakechroot; do
 
@@ -23,6 +23,16 @@ for chroot in chroot fakechroot; do
             ok "$chroot cd $d:" $t
         done
 
+        mkdir -p $testtree/$chroot-dir/a
+        t=`$srcdir/$chroot.sh $testtree /bin/test-getcwd /$chroot-dir fd:a fd:/ $chroot-dir/a fd:.. 2>&1 | tr '\n' ' '`
+        test "$t" = "/$chroot-dir /$chroot-dir/a / /$chroot-dir/a /$chroot-dir " || not
+        ok "$chroot getcwd after chdir and fchdir:" $t
+
+        mkdir -p $testtree/$chroot-old/x
+        t=`$srcdir/$chroot.sh $testtree /bin/test-getcwd /$chroot-old/x mv:/$chroot-old:/$chroot-new 2>&1 | tr '\n' ' '`
+        test "$t" = "/$chroot-old/x /$chroot-new/x " || not
+        ok "$chroot getcwd after rename of parent:" $t
+
         for d in '$FAKECHROOT_BASE'; do
             t=`$srcdir/$chroot.sh $testtree /bin/sh -c "cd $d && ls CHROOT"  2>&1`
             test "$t" != "CHROOT" || not
@@ -0,0 +1,41 @@
+#!/bin/sh
+
+srcdir=${srcdir:-.}
+. $srcdir/common.inc.sh
+
+prepare 4
+
+# the outer root has only empty library directories
+mkdir -p $testtree/n1/usr/lib $testtree/n1/lib
+$srcdir/testtree.sh $testtree/n1/n2
+test "`cat $testtree/n1/n2/CHROOT`" = "$testtree/n1/n2" || bail_out "$testtree/n1/n2"
+
+ldpath () {
+    $srcdir/fakechroot.sh $testtree /bin/test-chroot-exec "$@" -- /bin/sh -c 'echo $LD_LIBRARY_PATH' 2>&1
+}
+
+# the number of files tried by the dynamic linker
+probes () {
+    $srcdir/fakechroot.sh $testtree /bin/test-chroot-exec "$@" -- /bin/sh -c 'LD_DEBUG=libs /bin/cat /CHROOT' 2>&1 | grep -c 'trying file='
+}
+
+t1=`ldpath /`
+t2=`ldpath / / /`
+test "$t1" = "$t2" || not
+ok "repeated chroot keeps LD_LIBRARY_PATH:" $t2
+
+t=`ldpath /n1 /n2 | tr ':' '\n' | grep "/$testtree/n1/[^n]"`
+test -z "$t" || not
+ok "nested chroot drops library path of outer root:" $t
+
+t1=`probes /n1/n2`
+t2=`probes /n1 /n2`
+test -n "$t1" && test "$t1" = "$t2" || not
+ok "nested chroot probes as many files as direct chroot:" $t1 $t2
+
+t1=`probes /`
+t2=`probes / / /`
+test -n "$t1" && test "$t1" = "$t2" || not
+ok "repeated chroot probes as many files as single chroot:" $t1 $t2
+
+cleanup
@@ -3,7 +3,7 @@
 srcdir=${srcdir:-.}
 . $srcdir/common.inc.sh
 
-prepare 4
+prepare 6
 
 chroot=fakechroot
 
@@ -26,4 +26,12 @@ t=`LC_ALL=C $srcdir/$chroot.sh $testtree /bin/sh -c 'test-clearenv "/bin/sh -c \
 test -n "$t" || not
 ok "$chroot test-clearenv echo \$FAKECHROOT_VERSION returns" $t
 
+t=`LC_ALL=C $srcdir/$chroot.sh $testtree /bin/test-clearenv '/bin/sh -c "echo \$FAKECHROOT_VERSION"' 10 2>&1`
+test -n "$t" || not
+ok "$chroot test-clearenv 10 times echo \$FAKECHROOT_VERSION returns" $t
+
+t=`LC_ALL=C $srcdir/$chroot.sh $testtree /bin/test-clearenv '/bin/sh -c "echo \$CLEARED"' 10 2>&1`
+test -z "$t" || not
+ok "$chroot test-clearenv 10 times echo \$CLEARED returns" $t
+
 cleanup
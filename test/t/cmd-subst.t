@@ -3,7 +3,7 @@
 srcdir=${srcdir:-.}
 . $srcdir/common.inc.sh
 
-prepare 8
+prepare 16
 
 cwd=`pwd`
 cmddir=`cd $srcdir; pwd`/t
@@ -46,4 +46,55 @@ t=`$srcdir/fakechroot.sh $testtree /bin/pwd 2>&1`
 test "$t" = "/" || not
 ok "fakechroot pwd [8] is" $t
 
+subst=""
+for i in `seq 1 100`; do
+    subst="$subst/no/file$i=foo$i:"
+done
+
+export FAKECHROOT_CMD_SUBST="$subst/bin/pwd=$cmddir/cmd-subst-pwd.sh"
+
+t=`$srcdir/fakechroot.sh $testtree /bin/pwd 2>&1`
+test "$t" = "/bin/pwd" || not
+ok "fakechroot pwd [9] with 100 substitutions is" $t
+
+export FAKECHROOT_CMD_SUBST="/no/file=foo:*/pwd=$cmddir/cmd-subst-pwd.sh"
+
+t=`$srcdir/fakechroot.sh $testtree /bin/pwd 2>&1`
+test "$t" = "/bin/pwd" || not
+ok "fakechroot pwd [10] with basename is" $t
+
+export FAKECHROOT_CMD_SUBST="/no/file=foo:/b?n/[p]w*=$cmddir/cmd-subst-pwd.sh"
+
+t=`$srcdir/fakechroot.sh $testtree /bin/pwd 2>&1`
+test "$t" = "/bin/pwd" || not
+ok "fakechroot pwd [11] with pattern is" $t
+
+export FAKECHROOT_CMD_SUBST="/usr/*/pwd=foo:*/pwd=$cmddir/cmd-subst-pwd.sh:/bin/pwd=foo"
+
+t=`$srcdir/fakechroot.sh $testtree /bin/pwd 2>&1`
+test "$t" = "/bin/pwd" || not
+ok "fakechroot pwd [12] with the first match is" $t
+
+export FAKECHROOT_CMD_SUBST="/bin/p*=foo:/bin/pwd=$cmddir/cmd-subst-pwd.sh"
+
+t=`$srcdir/fakechroot.sh $testtree /bin/pwd 2>&1`
+test "$t" != "/bin/pwd" || not
+ok "fakechroot pwd [13] with the first pattern is not substituted"
+
+export FAKECHROOT_CMD_SUBST="/usr/bin/no-such-tool=$cmddir/cmd-subst-pwd.sh"
+
+t=`PATH=/usr/bin:/bin $srcdir/fakechroot.sh $testtree /bin/test-execlp no-such-tool arg 2>&1`
+test "$t" = "/usr/bin/no-such-tool" || not
+ok "fakechroot execlp of substituted command not in PATH is" $t
+
+t=`PATH=/usr/bin:/bin $srcdir/fakechroot.sh $testtree /bin/test-posix_spawnp no-such-tool arg 2>&1`
+test "$t" = "/usr/bin/no-such-tool" || not
+ok "fakechroot posix_spawnp of substituted command not in PATH is" $t
+
+export FAKECHROOT_CMD_SUBST="$subst*/no-file=foo:/no/*/file=foo"
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-exec-bench 20000 /no/such/file 2>&1`
+test "$t" -gt 0 2>/dev/null || not
+ok "fakechroot execve with 100 substitutions takes [ns]" $t
+
 cleanup
@@ -0,0 +1,55 @@
+#!/bin/sh
+
+srcdir=${srcdir:-.}
+. $srcdir/common.inc.sh
+
+prepare 8
+
+# the library is placed outside the library path of the fake chroot
+lib=`find $testtree -name 'libm.so.*' | head -n 1`
+test -n "$lib" || bail_out "libm.so not found in $testtree"
+mkdir -p $testtree/opt/lib
+cp -pL $lib $testtree/opt/lib/libfakechroot-test.so.1
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-dlopen libfakechroot-test.so.1 cos 2>&1`
+test "$t" != "/opt/lib/libfakechroot-test.so.1" || not
+ok "dlopen without index:" $t
+
+# chroot.fakechroot adds directories from ld.so.conf to LD_LIBRARY_PATH, so it
+# is removed after the index is written
+echo /opt/lib > $testtree/etc/ld.so.conf
+t=`FAKECHROOT_BASE_ORIG=$testtree ../scripts/ldconfig.fakechroot 2>&1`
+test $? = 0 && test -f $testtree/etc/ld.so.fakechroot || not
+ok "ldconfig.fakechroot writes /etc/ld.so.fakechroot" $t
+rm -f $testtree/etc/ld.so.conf
+
+t=`grep " libfakechroot-test.so.1 " $testtree/etc/ld.so.fakechroot 2>&1 | cut -d' ' -f3-`
+test "$t" = "libfakechroot-test.so.1 /opt/lib/libfakechroot-test.so.1" || not
+ok "index contains" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-dlopen libfakechroot-test.so.1 cos 2>&1`
+test "$t" = "/opt/lib/libfakechroot-test.so.1" || not
+ok "dlopen with index:" $t
+
+# the index doesn't override LD_LIBRARY_PATH
+mkdir -p $testtree/opt/lib2
+cp -p $testtree/opt/lib/libfakechroot-test.so.1 $testtree/opt/lib2
+lib2=`cd $testtree/opt/lib2 && pwd`
+t=`LD_LIBRARY_PATH=$lib2 $srcdir/fakechroot.sh $testtree /bin/test-dlopen libfakechroot-test.so.1 cos 2>&1`
+test "$t" = "/opt/lib2/libfakechroot-test.so.1" || not
+ok "dlopen with index and LD_LIBRARY_PATH:" $t
+
+# the names of the libraries which are not loaded anymore are freed
+t=`$srcdir/fakechroot.sh $testtree /bin/test-dlopen libfakechroot-test.so.1 cos 1000 2>&1`
+test "$t" = "/opt/lib/libfakechroot-test.so.1" || not
+ok "dlopen and dlclose 1000 times:" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-dl_iterate_phdr libfakechroot-test.so.1 1 2>&1`
+test "$t" = "/opt/lib/libfakechroot-test.so.1" || not
+ok "dl_iterate_phdr:" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-dl_iterate_phdr libfakechroot-test.so.1 8 2>&1`
+test "$t" = "/opt/lib/libfakechroot-test.so.1" || not
+ok "dl_iterate_phdr in threads:" $t
+
+cleanup
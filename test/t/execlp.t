@@ -3,7 +3,7 @@
 srcdir=${srcdir:-.}
 . $srcdir/common.inc.sh
 
-prepare 4
+prepare 8
 
 for chroot in chroot fakechroot; do
 
@@ -22,6 +22,23 @@ for chroot in chroot fakechroot; do
         test "$t" = "something" || not
         ok "$chroot execlp with test-echo returns" $t
 
+        mkdir -p $testtree/usr/local/bin
+        printf "#!/bin/sh\necho not executable\n" > $testtree/usr/local/bin/test-echo
+        chmod a-x $testtree/usr/local/bin/test-echo
+
+        t=`$srcdir/$chroot.sh $testtree /bin/sh -c "PATH=/usr/local/bin:/bin /bin/test-execlp test-echo something" 2>&1`
+        test "$t" = "something" || not
+        ok "$chroot execlp skips not executable file:" $t
+
+        rm -f $testtree/usr/local/bin/test-echo
+        mkdir -p $testtree/usr/local/sbin/test-echo
+
+        t=`$srcdir/$chroot.sh $testtree /bin/sh -c "PATH=/usr/local/sbin:/bin /bin/test-execlp test-echo something" 2>&1`
+        test "$t" = "something" || not
+        ok "$chroot execlp skips directory:" $t
+
+        rm -rf $testtree/usr/local/sbin/test-echo
+
     fi
 done
 
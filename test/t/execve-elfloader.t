@@ -3,7 +3,7 @@
 srcdir=${srcdir:-.}
 . $srcdir/common.inc.sh
 
-prepare 3
+prepare 8
 
 echo=${ECHO:-/bin/echo}
 
@@ -23,4 +23,31 @@ t=`$srcdir/$chroot.sh $testtree /usr/bin/env FAKECHROOT_ELFLOADER=$echo /bin/sh
 case "$t" in *"/bin/cat somefile");; *) not; esac
 ok "$chroot cat somefile with FAKECHROOT_ELFLOADER=$echo returns" $t
 
+t=`$srcdir/$chroot.sh $testtree /bin/test-realpath /proc/self/exe 2>&1`
+test "$t" = "/bin/test-realpath" || not
+ok "$chroot realpath /proc/self/exe returns" $t
+
+t=`$srcdir/$chroot.sh $testtree /bin/test-realpath /proc/self/cwd/somefile 2>&1`
+test "$t" = "/somefile" || not
+ok "$chroot realpath /proc/self/cwd/somefile returns" $t
+
+echo fakehostname > $testtree/etc/hostname
+
+t=`$srcdir/$chroot.sh $testtree /bin/cat /proc/self/root/etc/hostname 2>&1`
+test "$t" = "fakehostname" || not
+ok "$chroot cat /proc/self/root/etc/hostname returns" $t
+
+t=`$srcdir/$chroot.sh $testtree /bin/cat /proc/self/cwd/somefile 2>&1`
+test "$t" = "something" || not
+ok "$chroot cat /proc/self/cwd/somefile returns" $t
+
+elfloader=`ls /lib64/ld-linux*.so.* /lib/ld-linux*.so.* /lib/ld-musl-*.so.* 2>/dev/null | head -n 1`
+if [ -z "$elfloader" ]; then
+    skip 1 "dynamic linker not found"
+else
+    t=`FAKECHROOT_ELFLOADER=$elfloader $srcdir/$chroot.sh $testtree /bin/test-realpath /proc/self/exe 2>&1`
+    test "$t" = "/bin/test-realpath" || not
+    ok "$chroot realpath /proc/self/exe with FAKECHROOT_ELFLOADER=$elfloader returns" $t
+fi
+
 cleanup
@@ -3,7 +3,7 @@
 srcdir=${srcdir:-.}
 . $srcdir/common.inc.sh
 
-prepare 36
+prepare 38
 
 for chroot in chroot fakechroot; do
 
@@ -45,4 +45,14 @@ for chroot in chroot fakechroot; do
 
 done
 
+# 100 directories with 1000 files each
+mktree $testtree/fts-bench 100 1000
+
+# FTS_PHYSICAL and FTS_LOGICAL
+for option in 16 2; do
+    t=`$srcdir/fakechroot.sh $testtree /bin/test-fts-bench $option fts-bench 2>&1`
+    test "$t" -gt 0 2>/dev/null || not
+    ok "fakechroot fts with option $option over 100000 files takes [ns per entry]" $t
+done
+
 cleanup
@@ -0,0 +1,30 @@
+#!/bin/sh
+
+srcdir=${srcdir:-.}
+. $srcdir/common.inc.sh
+
+prepare 4
+
+mkdir -p $testtree/glob-dir/a $testtree/glob-dirx
+touch $testtree/glob-dir/a/f1 $testtree/glob-dir/a/f2 $testtree/glob-dirx/f3
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-glob '/glob-dir/a/*' 2>&1`
+test "`echo $t`" = "/glob-dir/a/f1 /glob-dir/a/f2" || not
+ok "fakechroot glob returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-glob '/glob-dir/a/*' '/glob-dir*' 2>&1`
+test "`echo $t`" = "/glob-dir/a/f1 /glob-dir/a/f2 /glob-dir /glob-dirx" || not
+ok "fakechroot glob with GLOB_APPEND returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-glob 'glob-dir/a/f*' 2>&1`
+test "`echo $t`" = "glob-dir/a/f1 glob-dir/a/f2" || not
+ok "fakechroot glob with relative pattern returns" $t
+
+# 50 directories with 1000 files each
+mktree $testtree/glob-bench 50 1000
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-glob-bench '/glob-bench/d*/f*' 2>&1`
+test "$t" -gt 0 2>/dev/null || not
+ok "fakechroot glob of 50000 files takes [ns per result]" $t
+
+cleanup
@@ -0,0 +1,40 @@
+#!/bin/sh
+
+srcdir=${srcdir:-.}
+. $srcdir/common.inc.sh
+
+prepare 6
+
+printf '#!/bin/sh\n' > $testtree/bin/script
+chmod +x $testtree/bin/script
+
+t=`$srcdir/fakechroot.sh $testtree /usr/bin/ldd /bin/test-hello 2>&1`
+echo "$t" | grep -q "^	libc\.so\.[0-9]* => /.* (0x0*)$" && ! echo "$t" | grep -q "$testtree" || not
+ok "ldd /bin/test-hello:" $t
+
+t=`$srcdir/fakechroot.sh $testtree /usr/bin/ldd /bin/script 2>&1`
+test "$t" = "	not a dynamic executable" || not
+ok "ldd /bin/script:" $t
+
+t=`$srcdir/fakechroot.sh $testtree /usr/bin/ldd /notexist 2>&1`
+test "$t" = "fakeldd: /notexist: No such file or directory" || not
+ok "ldd /notexist:" $t
+
+# nothing is written to fake chroot without FAKECHROOT_LDD_CACHE
+mkdir -p $testtree/var/cache
+t1=`$srcdir/fakechroot.sh $testtree /usr/bin/ldd /bin/test-hello 2>&1`
+test -n "$t1" && test ! -f $testtree/var/cache/ldd.fakechroot || not
+ok "ldd doesn't write /var/cache/ldd.fakechroot"
+
+cache=`pwd`/$testtree.ldd-cache
+rm -f $cache
+t=`FAKECHROOT_LDD_CACHE=$cache $srcdir/fakechroot.sh $testtree /usr/bin/ldd /bin/test-hello 2>&1`
+test -f $cache || not
+ok "ldd writes FAKECHROOT_LDD_CACHE"
+
+t2=`FAKECHROOT_LDD_CACHE=$cache $srcdir/fakechroot.sh $testtree /usr/bin/ldd /bin/test-hello 2>&1`
+test "$t1" = "$t2" || not
+ok "ldd with cache:" $t2
+rm -f $cache
+
+cleanup
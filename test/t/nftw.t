@@ -0,0 +1,51 @@
+#!/bin/sh
+
+srcdir=${srcdir:-.}
+. $srcdir/common.inc.sh
+
+prepare 8
+
+mkdir -p $testtree/nftw-dir/a/b
+for i in `$SEQ 1 100`; do
+    echo $i > $testtree/nftw-dir/a/f$i
+    mkdir $testtree/nftw-dir/a/b/d$i
+done
+ln -s a $testtree/nftw-dir/l
+
+# FTW_PHYS and FTW_PHYS|FTW_DEPTH
+for flags in 1 9; do
+
+    t=`$srcdir/fakechroot.sh $testtree /bin/test-nftw $flags nftw-dir 2>&1`
+    echo "$t" | grep -q "^nftw-dir/a/b/d100 " || not
+    ok "fakechroot nftw with flags $flags returns" `echo "$t" | wc -l` "entries"
+
+    p=`FAKECHROOT_PARALLEL_WALK=4 $srcdir/fakechroot.sh $testtree /bin/test-nftw $flags nftw-dir 2>&1`
+    test "$p" = "$t" || not
+    ok "fakechroot parallel nftw with flags $flags returns the same entries in the same order"
+
+done
+
+# Logical walk doesn't enter the same directory twice
+t=`$srcdir/fakechroot.sh $testtree /bin/test-nftw 0 nftw-dir 2>&1`
+test `echo "$t" | grep -c "^nftw-dir/[al]/f1 "` = 1 || not
+ok "fakechroot nftw with flags 0 skips known directories"
+
+# 100 directories with 1000 files each
+mktree $testtree/nftw-bench 100 1000
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-nftw-bench 1 nftw-bench 2>&1`
+test "$t" -gt 0 2>/dev/null || not
+ok "fakechroot nftw with flags 1 over 100000 files takes [ns per entry]" $t
+
+t=`FAKECHROOT_PARALLEL_WALK=4 $srcdir/fakechroot.sh $testtree /bin/test-nftw-bench 1 nftw-bench 2>&1`
+test "$t" -gt 0 2>/dev/null || not
+ok "fakechroot parallel nftw with flags 1 over 100000 files takes [ns per entry]" $t
+
+# Logical walk remembers every directory
+mktree $testtree/nftw-bench-dirs 100 200 mkdir
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-nftw-bench 0 nftw-bench-dirs 2>&1`
+test "$t" -gt 0 2>/dev/null || not
+ok "fakechroot nftw with flags 0 over 20000 directories takes [ns per entry]" $t
+
+cleanup
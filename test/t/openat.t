@@ -0,0 +1,37 @@
+#!/bin/sh
+
+srcdir=${srcdir:-.}
+. $srcdir/common.inc.sh
+
+prepare 6
+
+for chroot in chroot fakechroot; do
+
+    if [ $chroot = "chroot" ] && ! is_root; then
+        skip $(( $tap_plan / 2 )) "not root"
+    else
+
+        mkdir -p $testtree/$chroot-real/sub/dir
+        echo target > $testtree/$chroot-real/sub/target
+        echo file > $testtree/$chroot-real/sub/dir/file
+        ln -sf $chroot-real/sub/dir $testtree/$chroot-link
+
+        t=`echo $($srcdir/$chroot.sh $testtree /bin/test-openat /$chroot-link file 2>&1)`
+        test "$t" = "file file" || not
+        ok "$chroot openat for /$chroot-link file returns" $t
+
+        t=`echo $($srcdir/$chroot.sh $testtree /bin/test-openat /$chroot-link ../target 2>&1)`
+        test "$t" = "target target" || not
+        ok "$chroot openat for /$chroot-link ../target returns" $t
+
+        mkdir -p $testtree/$chroot-from
+        echo file > $testtree/$chroot-from/file
+        t=`echo $($srcdir/$chroot.sh $testtree /bin/test-openat /$chroot-from file /$chroot-from /$chroot-to 2>&1)`
+        test "$t" = "file file" || not
+        ok "$chroot openat for /$chroot-from file after rename to /$chroot-to returns" $t
+
+    fi
+
+done
+
+cleanup
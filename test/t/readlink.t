@@ -8,7 +8,7 @@ readlink=${readlink:-/bin/readlink}
 
 imax=$(( 180 - $(pwd | wc -c) ))
 
-prepare $(( 2 + 4 * $imax ))
+prepare $(( 4 + 4 * $imax ))
 
 for chroot in chroot fakechroot; do
 
@@ -24,6 +24,10 @@ for chroot in chroot fakechroot; do
         test "$t" = "$destfile" || not
         ok "$chroot readlink [\$PWD/$testtreex]" $t
 
+        t=`$srcdir/$chroot.sh $testtree /bin/test-readlink $chroot-replaced a bb cc /c 2>&1 | tr '\n' ' '`
+        test "$t" = "a bb cc /c " || not
+        ok "$chroot readlink of replaced symlink is" $t
+
         symlink=$chroot-
         destfile=$chroot-
 
@@ -3,7 +3,7 @@
 srcdir=${srcdir:-.}
 . $srcdir/common.inc.sh
 
-prepare 28
+prepare 33
 
 buf=`for i in $($SEQ 1 1024); do printf "A"; done`
 
@@ -58,8 +58,25 @@ for chroot in chroot fakechroot; do
         test "$t" = "/$chroot-file" || not
         ok "$chroot symlink's realpath with buf is really" $t
 
+        mkdir -p $testtree/$chroot-deep/a/b/c/d/e
+        ln -s /$chroot-deep/a/b $testtree/$chroot-deep/abs
+        ln -s ../a/b/c $testtree/$chroot-deep/a/rel
+
+        t=`$srcdir/$chroot.sh $testtree /bin/test-realpath /$chroot-deep/abs/c/d/../d/e 2>&1`
+        test "$t" = "/$chroot-deep/a/b/c/d/e" || not
+        ok "$chroot deep absolute symlink's realpath is really" $t
+
+        t=`$srcdir/$chroot.sh $testtree /bin/test-realpath /$chroot-deep/a/rel/d/e/../../../../../.. 2>&1`
+        test "$t" = "/" || not
+        ok "$chroot deep relative symlink's realpath is really" $t
+
     fi
 
 done
 
+# the path with both symlinks from the tests above
+t=`$srcdir/fakechroot.sh $testtree /bin/test-realpath-bench 100000 /fakechroot-deep/abs/c/d/../d/e 2>&1`
+test "$t" -gt 0 2>/dev/null || not
+ok "fakechroot realpath of deep symlinks takes [ns]" $t
+
 cleanup
@@ -0,0 +1,20 @@
+#!/bin/sh
+
+srcdir=${srcdir:-.}
+. $srcdir/common.inc.sh
+
+prepare 5
+
+cmddir=`cd $srcdir; pwd`/t
+
+for count in 0 1 100 1000; do
+    t=`$srcdir/fakechroot.sh $testtree /bin/test-setenv $count FAKECHROOT_CMD_SUBST "/bin/pwd=$cmddir/cmd-subst-pwd.sh" /bin/pwd 2>&1`
+    test "$t" = "/bin/pwd" || not
+    ok "fakechroot sees FAKECHROOT_CMD_SUBST after $count variables:" $t
+done
+
+t=`echo $($srcdir/fakechroot.sh $testtree /bin/test-environ /bin/test-environ 2>&1)`
+test "$t" = "TEST_ENVIRON_1 TEST_ENVIRON_2 TEST_ENVIRON_3" || not
+ok "fakechroot keeps the order of environ after unsetenv:" $t
+
+cleanup
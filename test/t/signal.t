@@ -0,0 +1,14 @@
+#!/bin/sh
+
+srcdir=${srcdir:-.}
+. $srcdir/common.inc.sh
+
+prepare 1
+
+echo file > $testtree/signal-file
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-signal /signal-file 2>&1`
+test "$t" = "ok" || not
+ok "fakechroot access() from a signal handler and after fork() returns" $t
+
+cleanup
@@ -5,7 +5,7 @@ srcdir=${srcdir:-.}
 
 abs_srcdir=${abs_srcdir:-`cd "$pwd" 2>/dev/null && pwd -P`}
 
-prepare 10
+prepare 20
 
 test_af_unix () {
     n=$1
@@ -24,6 +24,43 @@ test_af_unix () {
     kill $server_pid 2>/dev/null
 }
 
+test_af_unix_long () {
+    n=$1
+    dir=/`printf "%060d" 0`
+
+    mkdir -p $testtree$dir
+    $srcdir/$chroot.sh $testtree /bin/test-socket-af_unix-server $dir/$chroot-socket$n >$testtree/$chroot-socket$n.log 2>&1 &
+    server_pid=$!
+
+    sleep 3
+    test -S "$testtree$dir/$chroot-socket$n" || not
+    ok "$chroot af_unix server socket with long path created" `cat $testtree/$chroot-socket$n.log`
+
+    t=`grep '^getsockname: ' $testtree/$chroot-socket$n.log | sed 's/^getsockname: //'`
+    test "$t" = "$dir/$chroot-socket$n" || not
+    ok "$chroot af_unix getsockname with long path returns" $t
+
+    t=`$srcdir/$chroot.sh $testtree /bin/test-socket-af_unix-client $dir/$chroot-socket$n something 2>&1`
+    test "$t" = "something" || not
+    ok "$chroot af_unix client/server with long path returns" $t
+
+    kill $server_pid 2>/dev/null
+}
+
+test_af_unix_dgram () {
+    n=$1
+
+    rm -f $testtree/$chroot-dgram$n-server $testtree/$chroot-dgram$n-client
+    t=`$srcdir/$chroot.sh $testtree /bin/test-socket-af_unix-dgram /$chroot-dgram$n-server /$chroot-dgram$n-client something 2>&1`
+    test "`echo "$t" | grep '^recvfrom: '`" = "recvfrom: something /$chroot-dgram$n-client" || not
+    ok "$chroot af_unix sendto/recvfrom returns" $t
+
+    test "`echo "$t" | grep '^recvmsg: '`" = "recvmsg: something /$chroot-dgram$n-client" || not
+    ok "$chroot af_unix sendmsg/recvmsg returns" $t
+
+    rm -f $testtree/$chroot-dgram$n-server $testtree/$chroot-dgram$n-client
+}
+
 for chroot in chroot fakechroot; do
 
     if [ $chroot = "chroot" ] && ! is_root; then
@@ -34,11 +71,14 @@ for chroot in chroot fakechroot; do
 
         unset FAKECHROOT_AF_UNIX_PATH
         test_af_unix 1
+        test_af_unix_dgram 1
 
         if [ $chroot = "chroot" ]; then
-            skip 3 "test only for fakechroot"
+            skip 6 "test only for fakechroot"
         else
 
+            test_af_unix_long 3
+
             tmpdir=`src/test-mkdtemp /tmp/$chroot-socketXXXXXX 2>&1`
             test -d "$tmpdir" || not
             ok "mkdtemp /tmp/$chroot-socketXXXXXX returns $tmpdir"
@@ -0,0 +1,70 @@
+#!/bin/sh
+
+srcdir=${srcdir:-.}
+. $srcdir/common.inc.sh
+
+supervisor=`cd ../src 2>/dev/null && pwd -P`/fakechroot-supervisor
+
+if [ ! -x "$supervisor" ] || [ ! -x src/test-static-cat ]; then
+    skip_all "supervisor is not built"
+fi
+
+prepare 11
+
+FAKECHROOT_SUPERVISOR=$supervisor
+export FAKECHROOT_SUPERVISOR
+
+echo "something" > $testtree/supervisor-file
+mkdir $testtree/supervisor-dir
+ln -s ../supervisor-file $testtree/supervisor-dir/supervisor-symlink
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-static-cat /CHROOT 2>&1`
+test "$t" = "$testtree" || not
+ok "fakechroot static cat /CHROOT returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/sh -c "cd /supervisor-dir && /bin/test-static-cat ../supervisor-file" 2>&1`
+test "$t" = "something" || not
+ok "fakechroot static cat ../supervisor-file returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-static-cat /supervisor-dir/supervisor-symlink 2>&1`
+test "$t" = "something" || not
+ok "fakechroot static cat /supervisor-dir/supervisor-symlink returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-static-cat /supervisor-missing 2>&1`
+test "$t" = "open: No such file or directory" || not
+ok "fakechroot static cat /supervisor-missing returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-static-syscall rename /supervisor-file /supervisor-renamed 2>&1`
+test "$t" = "ok" && test -f $testtree/supervisor-renamed || not
+ok "fakechroot static rename /supervisor-file returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-static-syscall symlink /supervisor-renamed /supervisor-dir/supervisor-abslink 2>&1`
+t=`$srcdir/fakechroot.sh $testtree /bin/test-static-cat /supervisor-dir/supervisor-abslink 2>&1`
+test "$t" = "something" || not
+ok "fakechroot static symlink /supervisor-renamed returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-static-syscall chmod /supervisor-renamed 2>&1`
+test "$t" = "ok" && test "`ls -l $testtree/supervisor-renamed | cut -c1-10`" = "-rw-------" || not
+ok "fakechroot static chmod /supervisor-renamed returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-static-syscall creat /supervisor-created 2>&1`
+test "$t" = "ok" && test "`ls -l $testtree/supervisor-created | cut -c1-10`" = "-rw-rw-rw-" || not
+ok "fakechroot static creat /supervisor-created with umask 0 returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/test-static-syscall mkdir /supervisor-made 2>&1`
+test "$t" = "ok" && test "`ls -ld $testtree/supervisor-made | cut -c1-10`" = "drwxrwxrwx" || not
+ok "fakechroot static mkdir /supervisor-made with umask 0 returns" $t
+
+# chdir() with a path which has to be translated is a known limitation
+t=`$srcdir/fakechroot.sh $testtree /bin/test-static-syscall chdir /supervisor-dir 2>&1`
+case "$t" in
+    *"chdir(\"/supervisor-dir\") of statically linked binary can't be translated"*"chdir: Operation not permitted") ;;
+    *) not;;
+esac
+ok "fakechroot static chdir /supervisor-dir returns" $t
+
+t=`$srcdir/fakechroot.sh $testtree /bin/sh -c "cd / && /bin/test-static-syscall chdir supervisor-dir" 2>&1`
+test "$t" = "ok" || not
+ok "fakechroot static chdir supervisor-dir returns" $t
+
+cleanup
@@ -0,0 +1,52 @@
+#!/bin/sh
+
+srcdir=${srcdir:-.}
+. $srcdir/common.inc.sh
+
+# Upper bounds of syscalls done by one call of a wrapped function
+scenarios="
+access CHROOT 3
+access /CHROOT 2
+chdir . 4
+chdir / 3
+execve CHROOT 6
+execvp no-such-command 6
+faccessat CHROOT 3
+fts-logical walk 52
+fts-physical walk 32
+getcwd . 1
+lstat symlink 1
+lstat abslink 2
+readlink symlink 3
+realpath /deep/abs/c/d/e 8
+realpath /deep/a/b 4
+stat CHROOT 3
+"
+
+prepare $(( `echo "$scenarios" | grep -c .` ))
+
+ln -s CHROOT $testtree/symlink
+ln -s `cd $testtree && pwd`/CHROOT $testtree/abslink
+
+mkdir -p $testtree/walk/a/b/c
+touch $testtree/walk/f1 $testtree/walk/a/f2 $testtree/walk/a/b/f3 $testtree/walk/a/b/c/f4
+ln -s a $testtree/walk/l
+
+mkdir -p $testtree/deep/a/b/c/d/e
+ln -s /deep/a/b $testtree/deep/abs
+
+set -- $scenarios
+while [ $# -ge 3 ]; do
+    scenario=$1 path=$2 max=$3
+    shift 3
+
+    t=`$srcdir/fakechroot.sh $testtree /bin/test-syscall-count $scenario $path 2>&1`
+    if [ "$t" = "skip" ]; then
+        skip 1 "ptrace is not available"
+        continue
+    fi
+    test "$t" -le "$max" 2>/dev/null || not
+    ok "fakechroot $scenario $path does at most $max syscalls:" $t
+done
+
+cleanup